@@ -0,0 +1,198 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory_resource>
+#include <queue>
+#include <vector>
+
+#include "entity_store.h"
+#include "room_graph.h"
+#include "spatial_hash.h"
+
+/* Game time of a turn of the player. A mob acts once per its delay,
+ * so a mob with this delay acts once per turn.
+ */
+const int TURN_TIME = 12;
+
+// Distances of the AI levels of detail, Manhattan from the player.
+struct ActivityConfig {
+  /* Full AI within this distance or in the room of the player. */
+  int interest_radius = 24;
+  /* Coarse AI up to this distance, mobs further fall asleep. */
+  int dormant_radius = 48;
+  /* Sleeping mobs wake when the player comes this close. Less than
+   * `dormant_radius`, so mobs on the border do not flip every turn.
+   */
+  int wake_radius = 40;
+  /* Coarse AI acts this many times less often. */
+  int coarse_period = 4;
+};
+
+// Schedule of a map's mobs with levels of detail of their AI. Awake
+// mobs wait in a priority queue by the game time of their next action,
+// so a turn pops only the mobs which are due, O(log n) each. Mobs close
+// to the player think fully, further ones act less often and cheaply.
+// Far mobs are dormant: they are not in the queue and are not looked
+// at until the player enters the trigger zone around them, which is
+// kept in a spatial index. A turn costs in proportion to the count of
+// due mobs around the player, not of all mobs of the map.
+struct Activity {
+  using Handle = EntityStore::Handle;
+
+  /* Mob to act in a round, `index` in the entity columns. */
+  struct Pick {
+    uint32_t index;
+    bool coarse;
+  };
+
+  /* The queue and the zones are taken from `resource`. */
+  explicit Activity(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : queue{std::less<Entry>{}, std::pmr::vector<Entry>{resource}},
+        zones{resource},
+        woken{resource},
+        late{resource},
+        put_off{resource} {}
+
+  ActivityConfig config;
+
+  /* New mobs sleep until the player comes. */
+  void add(Handle handle, int x, int y) { zones.insert(handle, x, y); }
+
+  /* Forgets a destroyed mob, queued ones are dropped when due. */
+  void forget(Handle handle, int x, int y) { zones.erase(handle, x, y); }
+
+  /* Starts a turn: the clock of the map moves by a turn and mobs
+   * around (px, py) wake, due at once.
+   */
+  void begin_turn(const EntityStore& entities, int px, int py) {
+    now += TURN_TIME;
+    late.insert(late.end(), put_off.begin(), put_off.end());
+    put_off.clear();
+    int r = config.wake_radius;
+    woken.clear();
+    zones.for_each_candidate(px - r, py - r, px + r + 1, py + r + 1,
+                             [&](Handle handle) {
+                               auto i = entities.index(handle);
+                               if (std::abs(entities.xs[i] - px) +
+                                       std::abs(entities.ys[i] - py) <=
+                                   r) {
+                                 woken.push_back(handle);
+                               }
+                             });
+    for (auto handle : woken) {
+      auto i = entities.index(handle);
+      zones.erase(handle, entities.xs[i], entities.ys[i]);
+      queue.push(Entry{now, handle});
+    }
+  }
+
+  // Pops the mobs due at the earliest time within the turn. Puts the
+  // ones to act to `picks` in the order of the entity columns, the far
+  // ones fall asleep. Mobs put off by the last turn come in a round of
+  // their own after all the due ones. Returns false when no mob is due
+  // anymore.
+  bool next_round(const EntityStore& entities, const RoomGraph& rooms,
+                  int px, int py, std::vector<Pick>& picks) {
+    int room = rooms.find_area(px, py);
+    picks.clear();
+    auto pick = [&](Handle handle) {
+      if (!entities.alive(handle) || entities.is_dead(handle)) {
+        return;
+      }
+      auto i = entities.index(handle);
+      int x = entities.xs[i], y = entities.ys[i];
+      int d = std::abs(x - px) + std::abs(y - py);
+      if (d > config.dormant_radius) {
+        zones.insert(handle, x, y);
+        return;
+      }
+      bool full = d <= config.interest_radius ||
+                  (room != -1 && rooms.in_area(room, x, y));
+      picks.push_back(Pick{i, !full});
+    };
+    while (picks.empty() && !queue.empty() && queue.top().time <= now) {
+      round = queue.top().time;
+      while (!queue.empty() && queue.top().time == round) {
+        auto handle = queue.top().handle;
+        queue.pop();
+        pick(handle);
+      }
+    }
+    if (picks.empty() && !late.empty()) {
+      round = now;
+      for (auto handle : late) {
+        pick(handle);
+      }
+      late.clear();
+    }
+    std::sort(picks.begin(), picks.end(),
+              [](Pick lhs, Pick rhs) { return lhs.index < rhs.index; });
+    return !picks.empty();
+  }
+
+  /* Queues the next action of a mob picked by the last round. */
+  void schedule(Handle handle, int delay, bool coarse) {
+    queue.push(Entry{round + static_cast<uint64_t>(delay) *
+                                 (coarse ? config.coarse_period : 1),
+                     handle});
+  }
+
+  /* Keeps the mobs of the last round which fit in `actions`, the full
+   * ones first, and takes the other coarse ones out of the picks. They
+   * act in the next turn after its due mobs. Returns their count.
+   */
+  size_t defer_coarse(const EntityStore& entities, std::vector<Pick>& picks,
+                      size_t actions) {
+    auto full = static_cast<size_t>(std::count_if(
+        picks.begin(), picks.end(), [](Pick pick) { return !pick.coarse; }));
+    size_t coarse_left = actions > full ? actions - full : 0;
+    size_t kept = 0;
+    for (auto pick : picks) {
+      if (pick.coarse && coarse_left == 0) {
+        put_off.push_back(entities.handles[pick.index]);
+        continue;
+      }
+      coarse_left -= pick.coarse ? 1 : 0;
+      picks[kept++] = pick;
+    }
+    size_t deferred = picks.size() - kept;
+    picks.resize(kept);
+    return deferred;
+  }
+
+  /* Count of queued and put off mobs, destroyed ones may be among
+   * them.
+   */
+  size_t awake_count() const {
+    return queue.size() + late.size() + put_off.size();
+  }
+
+ private:
+  struct Entry {
+    uint64_t time;
+    Handle handle;
+
+    /* Earlier first, ties by slot so the order is fixed. */
+    bool operator<(const Entry& other) const {
+      if (time != other.time) {
+        return time > other.time;
+      }
+      return handle.index > other.handle.index;
+    }
+  };
+
+  std::priority_queue<Entry, std::pmr::vector<Entry>> queue;
+  /* Game time of the end of the current turn and of the last round. */
+  uint64_t now = 0;
+  uint64_t round = 0;
+  /* Dormant mobs by position, the zone of a mob is the diamond of
+   * `wake_radius` around it.
+   */
+  SpatialHash zones;
+  std::pmr::vector<Handle> woken;
+  /* Mobs put off by the last turn and by this one. */
+  std::pmr::vector<Handle> late;
+  std::pmr::vector<Handle> put_off;
+};
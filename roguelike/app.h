@@ -1,20 +1,36 @@
 #pragma once
+#include <chrono>
+#include <cstdint>
+
 #include "confirm_ui.h"
 #include "game_ui.h"
 #include "map.h"
 
+/* Keypress to frame time the engine aims at. */
+const auto TURN_BUDGET = std::chrono::milliseconds{16};
+/* Mob actions in a turn, a safety cap. A mob action takes about
+ * 0.3 us on a desktop (see bench_mob_tick), so the cap keeps them in
+ * a third of the budget. Ordinary turns stay far under it: the levels
+ * of detail leave a few thousand actions a turn at most, and the
+ * slowest turns of bench_turn_budget take 1.5 ms with no cap.
+ */
+const uint64_t TURN_ACTIONS = 20000;
+
 struct App {
   App(std::unique_ptr<World> world)
       : engine{std::make_shared<GameState>(std::move(world))},
         game_ui{engine},
-        state{State::Game} {}
+        state{State::Game} {
+    engine->set_turn_budget(TURN_BUDGET);
+    engine->set_action_budget(TURN_ACTIONS);
+  }
 
   int run() {
     while (true) {
       switch (state) {
         case State::Game: {
           game_ui.draw();
-          auto event = game_ui.next();
+          auto event = game_ui.next([&] { return engine->run_idle(); });
           switch (event.type) {
             case EventType::System: {
               switch (event.sys_event.type) {
@@ -0,0 +1,216 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Counts allocations which reach the upstream resource,
+// the system heap by default.
+struct CountingResource : std::pmr::memory_resource {
+  explicit CountingResource(
+      std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+      : upstream{upstream} {}
+
+  size_t allocations = 0;
+  size_t bytes = 0;
+
+ private:
+  void* do_allocate(size_t size, size_t alignment) override {
+    ++allocations;
+    bytes += size;
+    return upstream->allocate(size, alignment);
+  }
+
+  void do_deallocate(void* p, size_t size, size_t alignment) override {
+    upstream->deallocate(p, size, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const
+      noexcept override {
+    return this == &other;
+  }
+
+  std::pmr::memory_resource* upstream;
+};
+
+// Deleter of objects built in an arena: runs the destructor and gives
+// the memory back to the arena for reuse. Keeps the size of the most
+// derived object, so a pointer to a base frees it whole.
+struct ArenaDelete {
+  std::pmr::memory_resource* resource = nullptr;
+  size_t size = 0;
+  size_t alignment = 0;
+
+  template <typename T>
+  void operator()(T* ptr) const {
+    void* memory = ptr;
+    if constexpr (std::is_polymorphic_v<T>) {
+      memory = dynamic_cast<void*>(ptr);
+    }
+    ptr->~T();
+    if (resource != nullptr) {
+      resource->deallocate(memory, size, alignment);
+    }
+  }
+};
+
+template <typename T>
+using ArenaPtr = std::unique_ptr<T, ArenaDelete>;
+
+// Memory of an arena: blocks requested from the system, released all
+// at once on destruction. The first block has `initial_size` bytes.
+// Later ones grow geometrically from a quarter of it: what did not fit
+// is usually small next to what was sized up front.
+struct ArenaBlocks : std::pmr::memory_resource {
+  ArenaBlocks(size_t initial_size, std::pmr::memory_resource* upstream)
+      : next_size{initial_size}, upstream{upstream} {}
+
+  ArenaBlocks(const ArenaBlocks&) = delete;
+  ArenaBlocks& operator=(const ArenaBlocks&) = delete;
+
+  ~ArenaBlocks() override {
+    while (head != nullptr) {
+      Header* block = head;
+      head = block->next;
+      upstream->deallocate(block, block->size, alignof(std::max_align_t));
+    }
+  }
+
+ private:
+  /* Links the blocks, at the start of each. */
+  struct alignas(std::max_align_t) Header {
+    Header* next;
+    size_t size;
+  };
+
+  static constexpr size_t MIN_BLOCK = 16 * 1024;
+
+  void* do_allocate(size_t size, size_t alignment) override {
+    void* memory = std::align(alignment, size, cursor, left);
+    if (memory == nullptr) {
+      size_t block = std::max(next_size, sizeof(Header) + size + alignment);
+      auto header = static_cast<Header*>(
+          upstream->allocate(block, alignof(std::max_align_t)));
+      *header = Header{head, block};
+      next_size = std::max(MIN_BLOCK, head == nullptr ? block / 4 : block * 2);
+      head = header;
+      cursor = header + 1;
+      left = block - sizeof(Header);
+      memory = std::align(alignment, size, cursor, left);
+    }
+    cursor = static_cast<char*>(memory) + size;
+    left -= size;
+    return memory;
+  }
+
+  /* Freed memory is reused by the arena, not here. */
+  void do_deallocate(void*, size_t, size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const
+      noexcept override {
+    return this == &other;
+  }
+
+  Header* head = nullptr;
+  void* cursor = nullptr;
+  size_t left = 0;
+  size_t next_size;
+  std::pmr::memory_resource* upstream;
+};
+
+// Arena of a map. Small blocks come from a pool of size classes, large
+// ones (tile chunks mostly) are cut to their exact size: a pool would
+// round them up to the next power of two. Both take memory from
+// `ArenaBlocks`, the first of which has `initial_size` bytes. Freed
+// memory is reused: a large block by the next one of its size, so the
+// arena never holds more large blocks of a size than were live at once.
+// Objects and containers of the map allocate here through `resource()`;
+// they must not outlive the arena.
+struct Arena : private std::pmr::memory_resource {
+  explicit Arena(size_t initial_size = 16 * 1024)
+      : blocks{initial_size, &upstream},
+        pool{std::pmr::pool_options{MAX_POOL_CHUNK, LARGE - 1}, &blocks} {}
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  template <typename T, typename... Args>
+  ArenaPtr<T> make(Args&&... args) {
+    void* memory = allocate(sizeof(T), alignof(T));
+    return ArenaPtr<T>{new (memory) T(std::forward<Args>(args)...),
+                       ArenaDelete{this, sizeof(T), alignof(T)}};
+  }
+
+  std::pmr::memory_resource* resource() { return this; }
+
+  /* Count of blocks requested from the system so far. */
+  size_t system_allocations() const { return upstream.allocations; }
+
+ private:
+  /* Smallest block cut to its size. */
+  static constexpr size_t LARGE = 512;
+  /* Pool chunks grow geometrically up to this many blocks, so a size
+   * class used a little does not take much, and one used a lot is not
+   * spread over many chunks, which the pool searches one by one.
+   */
+  static constexpr size_t MAX_POOL_CHUNK = 1024;
+
+  /* Freed large blocks of one size, linked through their first word. */
+  struct FreeList {
+    size_t size = 0;
+    void* head = nullptr;
+  };
+
+  void* do_allocate(size_t size, size_t alignment) override {
+    if (size < LARGE) {
+      return pool.allocate(size, alignment);
+    }
+    auto list = find_list(size);
+    if (list != nullptr && list->head != nullptr) {
+      void* block = list->head;
+      list->head = *static_cast<void**>(block);
+      return block;
+    }
+    /* Any large block may be reused for any alignment. */
+    return blocks.allocate(size, std::max(alignment, alignof(std::max_align_t)));
+  }
+
+  void do_deallocate(void* block, size_t size, size_t alignment) override {
+    if (size < LARGE) {
+      pool.deallocate(block, size, alignment);
+      return;
+    }
+    auto list = find_list(size);
+    if (list == nullptr) {
+      list = &free_lists.emplace_back(FreeList{size, nullptr});
+    }
+    *static_cast<void**>(block) = list->head;
+    list->head = block;
+  }
+
+  FreeList* find_list(size_t size) {
+    for (auto& list : free_lists) {
+      if (list.size == size) {
+        return &list;
+      }
+    }
+    return nullptr;
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const
+      noexcept override {
+    return this == &other;
+  }
+
+  CountingResource upstream;
+  ArenaBlocks blocks;
+  std::pmr::unsynchronized_pool_resource pool;
+  /* A list per size ever freed. Sizes come from a few tile chunks,
+   * frames and containers, so there are few and the scan is short.
+   */
+  std::pmr::vector<FreeList> free_lists{&pool};
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+// Resumable behaviour of a mob: a coroutine which chooses the intent
+// of one step and suspends until the next one. Plans which span many
+// turns live in its locals and its position in the code, so a step is
+// one resume instead of a walk over all predicates.
+//
+// A behaviour takes `std::allocator_arg` and a memory resource as its
+// first arguments, its frame is allocated there.
+struct Behaviour {
+  struct promise_type {
+    Behaviour get_return_object() {
+      return Behaviour{
+          std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+
+    /* The resource is kept in a header before the frame to free it,
+     * so the usual delete matches.
+     */
+    template <typename... Args>
+    static void* operator new(size_t size, std::allocator_arg_t,
+                              std::pmr::memory_resource* frames, Args&&...) {
+      auto block =
+          static_cast<char*>(frames->allocate(HEADER + size, FRAME_ALIGN));
+      std::memcpy(block, &frames, sizeof(frames));
+      return block + HEADER;
+    }
+
+    static void operator delete(void* frame, size_t size) {
+      auto block = static_cast<char*>(frame) - HEADER;
+      std::pmr::memory_resource* frames;
+      std::memcpy(&frames, block, sizeof(frames));
+      frames->deallocate(block, HEADER + size, FRAME_ALIGN);
+    }
+  };
+
+  Behaviour() = default;
+
+  Behaviour(Behaviour&& other) noexcept
+      : handle{std::exchange(other.handle, nullptr)} {}
+
+  Behaviour& operator=(Behaviour&& other) noexcept {
+    std::swap(handle, other.handle);
+    return *this;
+  }
+
+  ~Behaviour() {
+    if (handle) {
+      handle.destroy();
+    }
+  }
+
+  explicit operator bool() const { return static_cast<bool>(handle); }
+
+  /* Runs the behaviour until it ends the step, a finished one idles. */
+  void resume() {
+    if (!handle.done()) {
+      handle.resume();
+    }
+  }
+
+ private:
+  static constexpr size_t FRAME_ALIGN = alignof(std::max_align_t);
+  /* Keeps the frame aligned after the header. */
+  static constexpr size_t HEADER = FRAME_ALIGN;
+  static_assert(sizeof(std::pmr::memory_resource*) <= HEADER);
+
+  explicit Behaviour(std::coroutine_handle<promise_type> handle)
+      : handle{handle} {}
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+/* Awaited by a behaviour to end the step. */
+inline std::suspend_always next_step() { return {}; }
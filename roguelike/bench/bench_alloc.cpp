@@ -0,0 +1,55 @@
+// Counts heap allocations made while building and destroying
+// generated maps. Objects, tile chunks, entity columns, buckets of the
+// spatial hash and the room graph live in the arena of their map, whose
+// first block is sized from the chunks of the plan, so the arena takes a
+// few blocks from the system however large the map is. The plan lives
+// in a scratch arena of `gen_map`. Items get their payloads only when
+// the player takes them.
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "map.h"
+
+static size_t heap_allocations = 0;
+
+void* operator new(size_t size) {
+  ++heap_allocations;
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+/* Memory resources ask for aligned blocks. */
+void* operator new(size_t size, std::align_val_t alignment) {
+  ++heap_allocations;
+  size_t align = static_cast<size_t>(alignment);
+  if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+int main() {
+  std::printf("%8s %14s %14s\n", "rooms", "heap allocs", "arena blocks");
+  for (int rooms : {15, 60, 240, 1000, 4000}) {
+    size_t before = heap_allocations;
+    auto map = gen_map(rooms, rooms);
+    size_t arena_blocks = map->system_allocations();
+    map.reset();
+    std::printf("%8d %14zu %14zu\n", rooms, heap_allocations - before,
+                arena_blocks);
+  }
+  return 0;
+}
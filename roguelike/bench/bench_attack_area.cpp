@@ -0,0 +1,128 @@
+// Compares the flat BFS engine and the bit-parallel flood fill against
+// the std::set based attack area search they replaced, for radii 1..32.
+// Counts heap allocations of the flood fill into a reused region once
+// it has run at the radius; there should be none.
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <new>
+#include <random>
+#include <set>
+
+#include "bfs.h"
+#include "flood_fill.h"
+#include "grid.h"
+
+using Area = std::set<std::pair<int, int>>;
+
+static size_t heap_allocations = 0;
+
+void* operator new(size_t size) {
+  ++heap_allocations;
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+/* Previous implementation of `bfs_get_attack_area`. */
+Area reference_attack_area(const Area& obstacles, int x, int y, int d) {
+  const int dx[] = {0, 0, 1, -1};
+  const int dy[] = {-1, 1, 0, 0};
+
+  Area vis;
+  std::deque<std::pair<int, int>> q;
+  q.push_back({x, y});
+  vis.insert({x, y});
+  while (!q.empty()) {
+    auto [nx, ny] = q.front();
+    q.pop_front();
+    for (size_t i = 0; i < sizeof(dx) / sizeof(int); ++i) {
+      auto xx = nx + dx[i];
+      auto yy = ny + dy[i];
+      if (obstacles.find({xx, yy}) == obstacles.end() &&
+          vis.find({xx, yy}) == vis.end() && abs(xx - x) + abs(yy - y) <= d) {
+        vis.insert({xx, yy});
+        q.push_back({xx, yy});
+      }
+    }
+  }
+  return vis;
+}
+
+template <typename F>
+double measure_us(int iterations, F&& f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    f();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         iterations;
+}
+
+int main() {
+  const int side = 128;
+  std::mt19937 gen(42);
+  Area obstacle_set;
+  BitGrid obstacles;
+  for (int x = 0; x < side; ++x) {
+    for (int y = 0; y < side; ++y) {
+      if (gen() % 5 == 0) {
+        obstacle_set.insert({x, y});
+        obstacles.set(x, y);
+      }
+    }
+  }
+
+  const int cx = side / 2, cy = side / 2;
+  FlatBfs bfs;
+  BitFlood flood;
+  Region area;
+  std::printf("%6s %8s %14s %14s %14s %12s\n", "radius", "tiles", "set, us",
+              "flat, us", "bits, us", "bits allocs");
+  for (int d = 1; d <= 32; ++d) {
+    auto expected = reference_attack_area(obstacle_set, cx, cy, d);
+    Area actual;
+    bfs.run(obstacles.view(), cx, cy, d,
+            [&](int x, int y) { actual.insert({x, y}); });
+    if (actual != expected ||
+        flood.run(obstacles.view(), cx, cy, d).size() != expected.size()) {
+      std::printf("area mismatch for radius %d\n", d);
+      return 1;
+    }
+
+    const int iterations = 200;
+    double set_us = measure_us(iterations, [&] {
+      volatile size_t n = reference_attack_area(obstacle_set, cx, cy, d).size();
+      (void)n;
+    });
+    double flat_us = measure_us(iterations, [&] {
+      size_t n = 0;
+      bfs.run(obstacles.view(), cx, cy, d, [&](int, int) { ++n; });
+      volatile size_t sink = n;
+      (void)sink;
+    });
+    flood.run(obstacles.view(), cx, cy, d, area);
+    size_t before = heap_allocations;
+    double bits_us = measure_us(iterations, [&] {
+      flood.run(obstacles.view(), cx, cy, d, area);
+      volatile size_t n = area.size();
+      (void)n;
+    });
+    size_t allocations = heap_allocations - before;
+    std::printf("%6d %8zu %14.2f %14.2f %14.2f %12zu\n", d, expected.size(),
+                set_us, flat_us, bits_us, allocations);
+    if (allocations != 0) {
+      std::printf("flood fill allocates at radius %d\n", d);
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,74 @@
+// Measures loading, full-map iteration and turn cost at 10k and 100k
+// entities.
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "map.h"
+#include "state.h"
+#include "test/world_fixture.h"
+
+namespace fs = std::filesystem;
+
+template <typename F>
+double measure_us(int iterations, F&& f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    f();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         iterations;
+}
+
+int main() {
+  std::printf("%10s %10s %16s %16s %14s %14s\n", "entities", "load, ms",
+              "scan objects, us", "scan columns, us", "query rect, us",
+              "turn, us");
+  for (int mobs : {10000, 100000}) {
+    auto dir = make_world("bench_entities_" + std::to_string(mobs),
+                          {.objects = mobs, .kinds = "$", .per_row = 300});
+    auto load_start = std::chrono::steady_clock::now();
+    auto state = GameState{std::make_unique<World>(dir)};
+    double load_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - load_start)
+                         .count();
+    const auto map = state.get_map();
+
+    /* Count entities in a window like the UI does. */
+    const int lx = 0, ux = 38, ly = 0, uy = 138;
+    volatile size_t sink = 0;
+    double objects_us = measure_us(50, [&] {
+      size_t n = 0;
+      for (const auto object : map.objects) {
+        auto [x, y] = object->get_pos();
+        n += lx <= x && x < ux && ly <= y && y < uy;
+      }
+      sink = n;
+    });
+    double columns_us = measure_us(50, [&] {
+      size_t n = 0;
+      for (size_t i = 0; i < map.objects.size(); ++i) {
+        int x = map.xs[i], y = map.ys[i];
+        n += lx <= x && x < ux && ly <= y && y < uy;
+      }
+      sink = n;
+    });
+    std::vector<IGameState::ObjectHandle> found;
+    double query_us = measure_us(50, [&] {
+      found.clear();
+      state.query_rect(lx, ly, ux, uy, found);
+      sink = found.size();
+    });
+    double turn_us = measure_us(10, [&] {
+      state.apply_event(IGameState::NoOpEvent{});
+    });
+    std::printf("%10zu %10.1f %16.1f %16.1f %14.1f %14.1f\n",
+                map.objects.size(), load_ms, objects_us, columns_us, query_us,
+                turn_us);
+    fs::remove_all(dir);
+  }
+  return 0;
+}
@@ -0,0 +1,33 @@
+// Measures construction time and heap usage of generated dungeons.
+#include <malloc.h>
+
+#include <chrono>
+#include <cstdio>
+
+#include "map.h"
+
+/* Heap in use, large blocks are mapped apart from the rest of it. */
+size_t heap_bytes() {
+  auto info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+}
+
+int main() {
+  std::printf("%8s %12s %12s\n", "rooms", "ms/map", "KiB/map");
+  for (int rooms : {15, 60, 240, 1000, 4000}) {
+    const int iterations = std::max(1, 3000 / rooms);
+    double ms = 0;
+    size_t bytes = 0;
+    for (int i = 0; i < iterations; ++i) {
+      size_t before = heap_bytes();
+      auto start = std::chrono::steady_clock::now();
+      auto map = gen_map(rooms, i);
+      auto end = std::chrono::steady_clock::now();
+      ms += std::chrono::duration<double, std::milli>(end - start).count();
+      bytes += heap_bytes() - before;
+    }
+    std::printf("%8d %12.3f %12zu\n", rooms, ms / iterations,
+                bytes / iterations / 1024);
+  }
+  return 0;
+}
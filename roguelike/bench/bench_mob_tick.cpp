@@ -0,0 +1,88 @@
+// Compares turns per second of the two-phase mob tick on one thread
+// and on all cores against moving every mob through its virtual
+// `move`, at 1k, 10k and 100k mobs. The tick thinks only for mobs
+// which are awake around the player. Checks that both ticks end with
+// the same positions.
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "map.h"
+#include "state.h"
+#include "test/world_fixture.h"
+#include "worker_pool.h"
+
+namespace fs = std::filesystem;
+
+template <typename F>
+double turns_per_second(int turns, F&& f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < turns; ++i) {
+    f();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return turns / std::chrono::duration<double>(end - start).count();
+}
+
+/* Positions of all objects of the current map. */
+std::vector<int> positions(const GameState& state) {
+  auto map = state.get_map();
+  std::vector<int> result(map.xs.begin(), map.xs.end());
+  result.insert(result.end(), map.ys.begin(), map.ys.end());
+  return result;
+}
+
+/* Runs `turns` ticks of the mobs of a fresh state on `pool`. */
+double tick_turns_per_second(const fs::path& dir, int turns, WorkerPool& pool,
+                             std::vector<int>& end_positions, size_t& awake) {
+  auto state = GameState{std::make_unique<World>(dir)};
+  /* The first turn builds the shared per-turn fields. */
+  state.apply_event(IGameState::NoOpEvent{});
+  auto [x, y] = state.get_player()->get_pos();
+  double tps = turns_per_second(turns, [&, x = x, y = y] {
+    DecisionTreeMob::tick(*state.get_current_map(), x, y, pool);
+  });
+  end_positions = positions(state);
+  awake = state.get_current_map()->awake_mobs();
+  return tps;
+}
+
+int main() {
+  WorkerPool serial{0};
+  auto& parallel = shared_pool();
+  std::printf("%10s %8s %16s %16s %16s %6s\n", "mobs", "awake",
+              "virtual, turn/s", "1 thread, turn/s", "all, turn/s", "same");
+  for (int mobs : {1000, 10000, 100000}) {
+    auto dir = make_world("bench_mob_tick_" + std::to_string(mobs),
+                          {.objects = mobs, .per_row = 200});
+    const int turns = mobs >= 100000 ? 5 : 50;
+
+    auto state = GameState{std::make_unique<World>(dir)};
+    state.apply_event(IGameState::NoOpEvent{});
+    std::vector<Mob*> all;
+    for (auto object : state.get_map().objects) {
+      if (auto mob = dynamic_cast<Mob*>(object); mob != nullptr) {
+        all.push_back(mob);
+      }
+    }
+    double virtual_tps = turns_per_second(turns, [&] {
+      for (auto mob : all) {
+        mob->move();
+      }
+    });
+
+    std::vector<int> serial_end, parallel_end;
+    size_t awake = 0;
+    double serial_tps =
+        tick_turns_per_second(dir, turns, serial, serial_end, awake);
+    double parallel_tps =
+        tick_turns_per_second(dir, turns, parallel, parallel_end, awake);
+    std::printf("%10zu %8zu %16.1f %16.1f %16.1f %6s\n", all.size(), awake,
+                virtual_tps, serial_tps, parallel_tps,
+                serial_end == parallel_end ? "yes" : "no");
+    fs::remove_all(dir);
+  }
+  return 0;
+}
@@ -0,0 +1,59 @@
+// Compares path queries over the room graph against the flat
+// jump point search, between the two furthest rooms of generated maps.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "map.h"
+
+template <typename F>
+double measure_us(int iterations, F&& f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    f();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         iterations;
+}
+
+int main() {
+  std::printf("%8s %8s %10s %14s %14s\n", "rooms", "areas", "path len",
+              "room graph, us", "flat JPS, us");
+  for (int n : {15, 50, 100}) {
+    auto map = gen_map(n, n);
+    const auto& rooms = map->get_rooms();
+
+    /* Rooms go first among the areas. */
+    RoomGraph::Cell from{}, to{};
+    int best = -1;
+    for (int a = 0; a < n; ++a) {
+      for (int b = 0; b < n; ++b) {
+        auto ca = rooms.center(a), cb = rooms.center(b);
+        int d = std::abs(ca.x - cb.x) + std::abs(ca.y - cb.y);
+        if (d > best) {
+          best = d;
+          from = ca;
+          to = cb;
+        }
+      }
+    }
+
+    std::vector<Pathfinder::Cell> path, flat;
+    const int radius = 1 << 20;
+    double graph_us = measure_us(
+        20, [&] { map->find_path(from.x, from.y, to.x, to.y, radius, path); });
+    /* The window must hold the whole map, it is a square around
+     * the start.
+     */
+    int window = 2 * best;
+    double flat_us = measure_us(5, [&] {
+      shared_pathfinder().find(map->get_obstacles(), from.x, from.y, to.x,
+                               to.y, window, flat);
+    });
+    std::printf("%8d %8zu %10zu %14.1f %14.1f\n", n, rooms.area_count(),
+                path.size(), graph_us, flat_us);
+  }
+  return 0;
+}
@@ -0,0 +1,45 @@
+// Measures latency of a game turn against count of objects on the map:
+// chests, items, orcs and bats. Then against count of border tiles,
+// which are terrain and should not change it.
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include "map.h"
+#include "state.h"
+#include "test/world_fixture.h"
+
+namespace fs = std::filesystem;
+
+/* Prints the mean time of a turn on such a map. */
+void run(int mobs, int objects, int borders) {
+  const int turns = 2000;
+  auto dir = make_world(
+      "bench_turn_" + std::to_string(objects) + "_" + std::to_string(borders),
+      {.mobs = mobs, .objects = objects, .kinds = "@/$&", .borders = borders});
+  auto state = GameState{std::make_unique<World>(dir)};
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < turns; ++i) {
+    state.apply_event(IGameState::NoOpEvent{});
+  }
+  auto end = std::chrono::steady_clock::now();
+  double us =
+      std::chrono::duration<double, std::micro>(end - start).count() / turns;
+  std::printf("%10zu %10d %10d %14.2f\n", state.get_map().objects.size(),
+              borders, mobs, us);
+  fs::remove_all(dir);
+}
+
+int main() {
+  const int mobs = 50;
+  std::printf("%10s %10s %10s %14s\n", "objects", "borders", "mobs",
+              "us/turn");
+  for (int objects : {100, 1000, 10000, 100000}) {
+    run(mobs, objects, 0);
+  }
+  for (int borders : {100, 1000, 10000, 100000}) {
+    run(mobs, 0, borders);
+  }
+  return 0;
+}
@@ -0,0 +1,49 @@
+// Measures turns of a crowded map with enters to generated maps under
+// several budgets of mob actions and a wall clock budget for jobs:
+// mean and worst time of a turn, misses of the deadline, actions of
+// far mobs put off and slices of map generation jobs run.
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include "map.h"
+#include "state.h"
+#include "test/world_fixture.h"
+
+namespace fs = std::filesystem;
+
+int main() {
+  const int enters = 8;
+  const int turns = 200;
+  const auto budget = std::chrono::milliseconds{16};
+  std::printf("%8s %10s %10s %10s %8s %10s %8s\n", "mobs", "actions",
+              "us/turn", "worst, us", "misses", "deferred", "jobs");
+  for (int mobs : {10000, 40000}) {
+    auto dir = make_world("bench_turn_budget_" + std::to_string(mobs),
+                          {.enters = enters, .objects = mobs});
+    for (int actions : {0, 100, 25}) {
+      auto state = GameState{std::make_unique<World>(dir, 1)};
+      state.set_turn_budget(budget);
+      state.set_action_budget(actions);
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < turns; ++i) {
+        /* Back and forth, so the mobs around keep waking. */
+        state.apply_event(i % 40 < 20 ? IGameState::PlayerMoveEvent::Down
+                                      : IGameState::PlayerMoveEvent::Up);
+      }
+      auto end = std::chrono::steady_clock::now();
+      double us =
+          std::chrono::duration<double, std::micro>(end - start).count() /
+          turns;
+      const auto& metrics = state.get_metrics();
+      std::printf("%8d %10d %10.1f %10lld %8llu %10llu %8llu\n", mobs, actions,
+                  us, static_cast<long long>(metrics.worst_turn.count()),
+                  static_cast<unsigned long long>(metrics.deadline_misses),
+                  static_cast<unsigned long long>(metrics.deferred_mobs),
+                  static_cast<unsigned long long>(metrics.job_slices));
+    }
+    fs::remove_all(dir);
+  }
+  return 0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "grid.h"
+
+// Breadth-first search bounded by a Manhattan radius around the origin.
+// Works on a flat (2d + 1) x (2d + 1) window, scratch buffers are kept
+// between calls, so a search does not allocate once they are big enough.
+struct FlatBfs {
+  // Visits every tile reachable from (x, y) through free tiles
+  // which are not further than `d` from (x, y), including the origin.
+  template <typename Visitor>
+  void run(BitGridView obstacles, int x, int y, int d, Visitor&& visit) {
+    const int dx[] = {0, 0, 1, -1};
+    const int dy[] = {-1, 1, 0, 0};
+
+    const int size = 2 * d + 1;
+    prepare(static_cast<size_t>(size) * size);
+
+    size_t head = 0, tail = 0;
+    auto push = [&](int xx, int yy) {
+      marks[static_cast<size_t>(xx - x + d) * size + (yy - y + d)] = epoch;
+      queue[tail++] = {xx, yy};
+      visit(xx, yy);
+    };
+    push(x, y);
+    while (head != tail) {
+      auto [nx, ny] = queue[head++];
+      for (size_t i = 0; i < sizeof(dx) / sizeof(int); ++i) {
+        int xx = nx + dx[i];
+        int yy = ny + dy[i];
+        if (std::abs(xx - x) + std::abs(yy - y) > d) {
+          continue;
+        }
+        if (marks[static_cast<size_t>(xx - x + d) * size + (yy - y + d)] !=
+                epoch &&
+            !obstacles.test(xx, yy)) {
+          push(xx, yy);
+        }
+      }
+    }
+  }
+
+ private:
+  struct Cell {
+    int x, y;
+  };
+
+  void prepare(size_t area) {
+    if (marks.size() < area) {
+      marks.assign(area, 0);
+      queue.resize(area);
+      epoch = 0;
+    }
+    /* Marks of previous runs become stale without clearing. */
+    if (++epoch == 0) {
+      std::fill(marks.begin(), marks.end(), 0);
+      epoch = 1;
+    }
+  }
+
+  /* Tile is visited by the current run iff its mark equals `epoch`. */
+  std::vector<uint32_t> marks;
+  std::vector<Cell> queue;
+  uint32_t epoch = 0;
+};
@@ -1,142 +1,297 @@
 #pragma once
 #include <algorithm>
-#include <functional>
+#include <cstdint>
+#include <cstdlib>
 #include <memory>
 #include <utility>
 #include <vector>
 
+#include "distance_field.h"
 #include "entities.h"
+#include "intent.h"
+#include "pathfinder.h"
+#include "rng.h"
 
-struct DecisionTreeNode {
-  virtual std::shared_ptr<DecisionTreeNode> decide() const = 0;
-  virtual ~DecisionTreeNode() = default;
-};
-
+// Decision tree compiled into a flat table of nodes. A node either
+// branches on a predicate or chooses an action and ends the turn.
+// Predicates and actions are plain functions of the mob, so one
+// immutable table serves every mob of a type, and all per-mob state
+// lives in the mob's blackboard.
 template <typename T>
-struct RandowWalkNode : DecisionTreeNode {
-  RandowWalkNode(int sx, int sy, int max_dist, T &obj)
-      : sx{sx}, sy{sy}, max_dist{max_dist}, obj(obj) {}
-
-  std::shared_ptr<DecisionTreeNode> decide() const override {
-    const int DX_SZ = 5;
-    const int dx[] = {0, 0, 0, 1, -1};
-    const int dy[] = {0, 1, -1, 0, 0};
-    auto current_map = obj.get_state()->get_current_map();
-    auto [x, y] = obj.get_pos();
-    int vars[DX_SZ]{};
-    int j = 0;
-    for (int i = 0; i < DX_SZ; ++i) {
-      int xx = x + dx[i];
-      int yy = y + dy[i];
-      if (!current_map->has_object(xx, yy,
-                                   static_cast<IGameState::Object *>(&obj))) {
-        vars[j++] = i;
-      }
-    }
-    if (j != 0) {
-      int choose = rand() % j;
-      x += dx[vars[choose]];
-      y += dy[vars[choose]];
-      obj.set_pos(x, y);
+struct DecisionTable {
+  using Predicate = bool (*)(T &);
+  using Action = void (*)(T &);
+
+  struct Node {
+    /* Leaves have no predicate. */
+    Predicate predicate;
+    Action action;
+    /* Next node when the predicate is false and true. */
+    uint16_t next[2];
+  };
+
+  uint16_t leaf(Action action) {
+    nodes.push_back(Node{nullptr, action, {0, 0}});
+    return static_cast<uint16_t>(nodes.size() - 1);
+  }
+
+  uint16_t branch(Predicate predicate, uint16_t if_true, uint16_t if_false) {
+    nodes.push_back(Node{predicate, nullptr, {if_false, if_true}});
+    return static_cast<uint16_t>(nodes.size() - 1);
+  }
+
+  /* Walks the table from the root to a leaf. */
+  uint16_t decide(T &obj) const {
+    uint16_t i = root;
+    while (nodes[i].predicate != nullptr) {
+      i = nodes[i].next[nodes[i].predicate(obj)];
     }
-    return nullptr;
+    return i;
   }
 
- private:
-  /* Spawnpoint. */
-  int sx, sy;
-  /* If distance from spawnpoint at least `max_dist`,
-   * then tries to return back, otherwise chooses a random direction.
+  void act(uint16_t leaf, T &obj) const { nodes[leaf].action(obj); }
+
+  void run(T &obj) const { act(decide(obj), obj); }
+
+  uint16_t root = 0;
+  std::vector<Node> nodes;
+};
+
+/* Cached path of a pathfinding mob, see `follow_path_to`. */
+struct PathCache {
+  using Cell = Pathfinder::Cell;
+
+  /* `path[step]` is the position of the mob. */
+  std::vector<Cell> path;
+  size_t step = 0;
+  Cell target{};
+  uint64_t version = 0;
+  bool planned = false;
+};
+
+// Mutable per-mob state of decision tree actions and predicates.
+struct Blackboard {
+  /* Manhattan distance to the player at the start of the step. */
+  int distance = 0;
+  /* Turns left for a timed behaviour, e.g. pursuit. */
+  uint16_t timer = 0;
+  /* Allocated on the first pathfinding. */
+  std::unique_ptr<PathCache> path;
+  /* Own random stream of the mob, so draws do not depend on
+   * the order or on the thread mobs are run in.
    */
-  int max_dist;
-  T &obj;
+  SplitMix64 random;
 };
 
-/* Use a comparator to choose: be closer or farther to the player. */
-template <typename T, typename Comparator>
-struct DistanceComparatorNode : DecisionTreeNode {
-  DistanceComparatorNode(T &obj) : obj{obj} {}
-
-  std::shared_ptr<DecisionTreeNode> decide() const override {
-    auto [x, y] = obj.get_pos();
-    auto [px, py] = obj.get_state()->get_player()->get_pos();
-    auto map = obj.get_state()->get_current_map();
-    const int dx[] = {0, 1, -1, 0, 0};
-    const int dy[] = {0, 0, 0, 1, -1};
-    std::pair<int, int> vars[5]{};
-    int j = 0;
-    for (int i = 0; i < sizeof(dx) / sizeof(int); ++i) {
-      int xx = x + dx[i];
-      int yy = y + dy[i];
-      if (!map->has_object(xx, yy, static_cast<IGameState::Object *>(&obj))) {
-        vars[j].second = i;
-        vars[j].first = abs(xx - px) + abs(yy - py);
-        j++;
-      }
-    }
-    auto cmp = Comparator{};
-    sort(vars, vars + j, cmp);
-    int cntv = 0;
-    while (cntv < sizeof(vars) / sizeof(vars[0]) && !cmp(vars[cntv], vars[0]) &&
-           !cmp(vars[0], vars[cntv])) {
-      cntv++;
-    }
-    if (cntv != 0) {
-      int choose = rand() % cntv;
-      int new_x = x + dx[vars[choose].second];
-      int new_y = y + dy[vars[choose].second];
-      obj.set_pos(new_x, new_y);
+template <typename T>
+void move_to(T &obj, int x, int y) {
+  obj.intent() = Intent{Intent::Kind::MOVE, x, y, 0};
+}
+
+/* Steps to a random free neighbouring tile not further than
+ * `max_dist` from (sx, sy), or stays.
+ */
+template <typename T>
+void random_walk_near(T &obj, int sx, int sy, int max_dist) {
+  const int DX_SZ = 5;
+  const int dx[] = {0, 0, 0, 1, -1};
+  const int dy[] = {0, 1, -1, 0, 0};
+  auto current_map = obj.get_state()->get_current_map();
+  auto [x, y] = obj.get_pos();
+  int vars[DX_SZ]{};
+  int j = 0;
+  for (int i = 0; i < DX_SZ; ++i) {
+    int xx = x + dx[i];
+    int yy = y + dy[i];
+    if (std::abs(xx - sx) + std::abs(yy - sy) <= max_dist &&
+        !current_map->has_object(xx, yy,
+                                 static_cast<IGameState::Object *>(&obj))) {
+      vars[j++] = i;
     }
-    return nullptr;
   }
+  obj.intent() = Intent{};
+  if (j != 0) {
+    int choose =
+        static_cast<int>(uniform_below(obj.get_blackboard().random, j));
+    move_to(obj, x + dx[vars[choose]], y + dy[vars[choose]]);
+  }
+}
 
- private:
-  T &obj;
-};
-
+/* Steps to a random free neighbouring tile or stays. */
 template <typename T>
-struct AttackNode : DecisionTreeNode {
-  AttackNode(T &obj) : obj(obj){};
+void random_walk(T &obj) {
+  auto [x, y] = obj.get_pos();
+  random_walk_near(obj, x, y, 1);
+}
 
-  std::shared_ptr<DecisionTreeNode> decide() const override {
-    int dmg = obj.get_damage();
-    obj.get_state()->damage_player(dmg);
-    return nullptr;
+/* Use a comparator to choose: be closer or farther to the player.
+ * Distances go around walls, they are read from the field
+ * which the state builds once per turn for all mobs. Tiles of other
+ * mobs count, the mob follows them if they go; free tiles are
+ * preferred among equally good ones.
+ */
+template <typename T, typename Comparator>
+void keep_distance(T &obj) {
+  auto [x, y] = obj.get_pos();
+  const auto &distance = obj.get_state()->get_player_distance();
+  auto map = obj.get_state()->get_current_map();
+  const int dx[] = {0, 1, -1, 0, 0};
+  const int dy[] = {0, 0, 0, 1, -1};
+  std::pair<int, int> vars[5]{};
+  int j = 0;
+  for (size_t i = 0; i < sizeof(dx) / sizeof(int); ++i) {
+    int xx = x + dx[i];
+    int yy = y + dy[i];
+    if (!map->is_blocked(xx, yy)) {
+      vars[j].second = static_cast<int>(i);
+      vars[j].first = distance.get(xx, yy);
+      j++;
+    }
+  }
+  /* Steps cut off from the player lead neither to it nor away from
+   * it. When all of them are, the mob is walled off from the player
+   * within the field and only Manhattan distance is left.
+   */
+  int reachable = static_cast<int>(
+      std::partition(vars, vars + j,
+                     [](std::pair<int, int> var) {
+                       return var.first != DistanceField::UNREACHABLE;
+                     }) -
+      vars);
+  if (reachable != 0) {
+    j = reachable;
+  } else {
+    for (int k = 0; k < j; ++k) {
+      vars[k].first = std::abs(x + dx[vars[k].second] - distance.origin_x()) +
+                      std::abs(y + dy[vars[k].second] - distance.origin_y());
+    }
+  }
+  auto cmp = Comparator{};
+  sort(vars, vars + j, cmp);
+  int cntv = 0;
+  while (cntv < j && !cmp(vars[cntv], vars[0]) && !cmp(vars[0], vars[cntv])) {
+    cntv++;
+  }
+  auto is_free = [&](std::pair<int, int> var) {
+    return !map->has_object(x + dx[var.second], y + dy[var.second],
+                            static_cast<IGameState::Object *>(&obj));
+  };
+  int free = static_cast<int>(
+      std::stable_partition(vars, vars + cntv, is_free) - vars);
+  if (free != 0) {
+    cntv = free;
+  }
+  obj.intent() = Intent{};
+  if (cntv != 0) {
+    int choose = static_cast<int>(
+        uniform_below(obj.get_blackboard().random, cntv));
+    move_to(obj, x + dx[vars[choose].second], y + dy[vars[choose].second]);
   }
+}
 
- private:
-  T &obj;
-};
+template <typename T>
+void attack(T &obj) {
+  obj.intent() =
+      Intent{Intent::Kind::ATTACK, 0, 0, obj.get_damage()};
+}
 
 template <typename T>
-struct ConditionNode : DecisionTreeNode {
-  struct Node {
-    std::function<bool(T &)> predicate;
-    std::shared_ptr<DecisionTreeNode> next;
-  };
+void no_op(T &obj) {
+  obj.intent() = Intent{};
+}
 
-  ConditionNode(T &obj, std::vector<Node> nodes,
-                std::shared_ptr<DecisionTreeNode> default_)
-      : obj(obj), nodes(std::move(nodes)), default_(std::move(default_)) {}
+/* Target moves up to this distance are handled by a local search. */
+const int PATH_REPAIR_DISTANCE = 3;
 
-  std::shared_ptr<DecisionTreeNode> decide() const {
-    for (const auto &node : nodes) {
-      if (node.predicate(obj)) {
-        return node.next;
-      }
+/* Extends the cached path from the old target to the new one,
+ * cutting the loops this makes.
+ */
+template <typename M>
+bool repair_path(M *map, PathCache &cache, PathCache::Cell to) {
+  thread_local std::vector<PathCache::Cell> detour;
+  if (!shared_pathfinder().find(map->get_obstacles(), cache.target.x,
+                                cache.target.y, to.x, to.y,
+                                2 * PATH_REPAIR_DISTANCE, detour)) {
+    return false;
+  }
+  auto &path = cache.path;
+  path.erase(path.begin(), path.begin() + cache.step);
+  cache.step = 0;
+  for (size_t i = 1; i < detour.size(); ++i) {
+    auto loop = std::find(path.begin(), path.end(), detour[i]);
+    if (loop != path.end()) {
+      path.erase(loop + 1, path.end());
+    } else {
+      path.push_back(detour[i]);
     }
-    return default_;
   }
+  cache.target = to;
+  return true;
+}
 
- private:
-  T &obj;
-  std::vector<Node> nodes;
-  std::shared_ptr<DecisionTreeNode> default_;
-};
-
-struct NoOpNode : DecisionTreeNode {
-  std::shared_ptr<DecisionTreeNode> decide() const;
-};
+/* Makes the cached path lead from (x, y) to (tx, ty). It is repaired
+ * when the target moves a little and planned again only when the map
+ * changes, the mob leaves the path or the target goes too far.
+ */
+template <typename M>
+bool update_path(M *map, PathCache &cache, int x, int y, int tx, int ty,
+                 int radius) {
+  PathCache::Cell to{tx, ty};
+  bool valid = cache.planned && cache.version == map->get_version();
+  if (valid && cache.path.empty()) {
+    /* The target is known to be unreachable. */
+    if (cache.target == to) {
+      return false;
+    }
+    valid = false;
+  }
+  valid = valid && cache.step < cache.path.size() &&
+          cache.path[cache.step] == PathCache::Cell{x, y};
+  if (valid && !(cache.target == to)) {
+    valid = std::abs(tx - cache.target.x) + std::abs(ty - cache.target.y) <=
+                PATH_REPAIR_DISTANCE &&
+            repair_path(map, cache, to);
+  }
+  if (!valid) {
+    cache.planned = true;
+    cache.version = map->get_version();
+    cache.target = to;
+    cache.step = 0;
+    if (!map->find_path(x, y, tx, ty, radius, cache.path)) {
+      cache.path.clear();
+      return false;
+    }
+  }
+  return cache.step + 1 < cache.path.size();
+}
 
-// Interpretate a decision tree.
-void interpretate(std::shared_ptr<DecisionTreeNode> root);
+/* Steps along a path around static obstacles to (tx, ty), which is
+ * not further than `radius`. The path is kept in the blackboard; its
+ * next tile may be held by a mob, then the step follows that mob.
+ * Returns false if there is no such path.
+ */
+template <typename T>
+bool follow_path_to(T &obj, int tx, int ty, int radius) {
+  auto &cache = obj.get_blackboard().path;
+  if (cache == nullptr) {
+    cache = std::make_unique<PathCache>();
+  }
+  auto [x, y] = obj.get_pos();
+  auto map = obj.get_state()->get_current_map();
+  obj.intent() = Intent{};
+  /* The step chosen last turn has been taken. */
+  auto &path = cache->path;
+  if (cache->step + 1 < path.size() &&
+      path[cache->step + 1] == PathCache::Cell{x, y}) {
+    ++cache->step;
+  }
+  if (!update_path(map, *cache, x, y, tx, ty, radius)) {
+    /* Either unreachable or already there. */
+    return !path.empty();
+  }
+  auto next = path[cache->step + 1];
+  if (!map->is_blocked(next.x, next.y)) {
+    move_to(obj, next.x, next.y);
+  }
+  return true;
+}
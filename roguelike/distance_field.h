@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "grid.h"
+
+// Distances by free tiles from one origin, within a square window of
+// the given radius around it. Built by a single breadth-first search,
+// then every query is O(1), however many mobs ask.
+struct DistanceField {
+  static constexpr int UNREACHABLE = UINT16_MAX;
+
+  void build(BitGridView obstacles, int x, int y, int radius) {
+    ox = x;
+    oy = y;
+    r = radius;
+    size = 2 * radius + 1;
+    dist.assign(static_cast<size_t>(size) * size, UNREACHABLE);
+    queue.resize(dist.size());
+
+    const int dx[] = {0, 0, 1, -1};
+    const int dy[] = {-1, 1, 0, 0};
+    size_t head = 0, tail = 0;
+    dist[offset(x, y)] = 0;
+    queue[tail++] = {x, y};
+    while (head != tail) {
+      auto [cx, cy] = queue[head++];
+      int next = dist[offset(cx, cy)] + 1;
+      for (size_t i = 0; i < sizeof(dx) / sizeof(int); ++i) {
+        int xx = cx + dx[i];
+        int yy = cy + dy[i];
+        if (!inside(xx, yy) || dist[offset(xx, yy)] != UNREACHABLE ||
+            obstacles.test(xx, yy)) {
+          continue;
+        }
+        dist[offset(xx, yy)] = static_cast<uint16_t>(next);
+        queue[tail++] = {xx, yy};
+      }
+    }
+  }
+
+  /* Distance to the origin. Outside the window it falls back to
+   * Manhattan distance, tiles cut off by obstacles are UNREACHABLE.
+   */
+  int get(int x, int y) const {
+    if (!inside(x, y)) {
+      return std::abs(x - ox) + std::abs(y - oy);
+    }
+    return dist[offset(x, y)];
+  }
+
+  int origin_x() const { return ox; }
+  int origin_y() const { return oy; }
+
+ private:
+  struct Cell {
+    int x, y;
+  };
+
+  bool inside(int x, int y) const {
+    return std::abs(x - ox) <= r && std::abs(y - oy) <= r;
+  }
+
+  size_t offset(int x, int y) const {
+    return static_cast<size_t>(x - ox + r) * size + (y - oy + r);
+  }
+
+  int ox{}, oy{};
+  int r = -1;
+  int size = 0;
+  /* Buffers are reused by the following builds. */
+  std::vector<uint16_t> dist;
+  std::vector<Cell> queue;
+};
@@ -10,8 +10,7 @@
 std::tuple<int, int> IGameState::Object::get_pos() const { return {x, y}; }
 
 bool IGameState::Object::on_same_pos(const IGameState::Object* other) const {
-  auto [xo, yo] = other->get_pos();
-  return x == xo && y == yo;
+  return get_pos() == other->get_pos();
 }
 
 IGameState::Object::Object(int x, int y) : x{x}, y{y} {}
@@ -1,23 +1,21 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
 #include <optional>
-#include <set>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "region.h"
+
 // Abstract class of game state.
 struct IGameState {
   enum class ObjectDescriptor {
     PLAYER,
-    WALL,
     CHEST,
-    STONE,
     ENTER,
-    HORIZONTAL_BORDER,
-    VERTICAL_BORDER,
-    CORNER,
     EXIT,
     ORC,
     BAT,
@@ -25,6 +23,37 @@ struct IGameState {
     ObjectDescriptorMAX,
   };
 
+  // Static terrain is not a set of objects, map stores a tile per cell.
+  enum class Terrain : uint8_t {
+    NONE,
+    WALL,
+    STONE,
+    HORIZONTAL_BORDER,
+    VERTICAL_BORDER,
+    CORNER,
+    TerrainMAX,
+  };
+
+  // Reference to an object of the current map. Unlike a pointer,
+  // it is safe to keep: it resolves to nothing once the object is removed.
+  struct ObjectHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const ObjectHandle& other) const {
+      return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const ObjectHandle& other) const {
+      return !(*this == other);
+    }
+  };
+
+  /* The player is not owned by maps, but can be referred by a handle. */
+  static constexpr ObjectHandle PLAYER_HANDLE{
+      .index = UINT32_MAX,
+      .generation = 1,
+  };
+
   struct Object {
     Object(int x, int y);
 
@@ -39,7 +68,8 @@ struct IGameState {
 
     virtual ~Object() = default;
 
-    void set_pos(int xx, int yy);
+    // Objects kept by a map override it to keep the map up to date.
+    virtual void set_pos(int xx, int yy);
 
    protected:
     int x, y;
@@ -63,9 +93,13 @@ struct IGameState {
       IGameState::ItemDescriptor descriptor;
   };
 
+  // Objects of the map, except the player. Columns are indexed together.
   struct MapDescription {
     const std::string_view name;
-    const std ::vector<Object*>& objects;
+    const std::pmr::vector<Object*>& objects;
+    const std::pmr::vector<ObjectHandle>& handles;
+    const std::pmr::vector<int>& xs;
+    const std::pmr::vector<int>& ys;
   };
 
   struct IHealthable : Object {
@@ -78,7 +112,8 @@ struct IGameState {
   struct IPlayer : IHealthable {
     IPlayer(int x, int y);
 
-    virtual std::set<std::pair<int, int>> get_attack_area() const = 0;
+    /* Fills `area`, reusing its storage. */
+    virtual void get_attack_area(Region& area) const = 0;
 
     virtual int get_lvl() const = 0;
 
@@ -90,7 +125,8 @@ struct IGameState {
   struct IMob : IHealthable {
     IMob(int x, int y);
 
-    virtual std::set<std::pair<int, int>> get_attack_area() const = 0;
+    /* Fills `area`, reusing its storage. */
+    virtual void get_attack_area(Region& area) const = 0;
   };
 
   struct IEnter : Object {
@@ -107,7 +143,7 @@ struct IGameState {
 
   struct ApplyObjectEvent {
       // Object to apply.
-      Object *object;
+      ObjectHandle object;
   };
 
   struct ApplyItemEvent {
@@ -140,10 +176,26 @@ struct IGameState {
 
   virtual IPlayer* get_player() const = 0;
 
+  // Object of the current map or the player, nullptr if it is removed.
+  virtual Object* get_object(ObjectHandle handle) const = 0;
+
   virtual const MapDescription get_map() const = 0;
 
+  // Objects of the current map with x in [lx, ux) and y in [ly, uy),
+  // the player last if it is there. Cost depends on the count of
+  // nearby objects, not on the size of the map.
+  virtual void query_rect(int lx, int ly, int ux, int uy,
+                          std::vector<ObjectHandle>& out) const = 0;
+
+  // Get terrain of the current map.
+  virtual Terrain get_terrain(int x, int y) const = 0;
+
   virtual void apply_event(const Event& event) = 0;
 
+  // Runs a slice of deferred work while the UI waits for input.
+  // Returns false when no work is left.
+  virtual bool run_idle() = 0;
+
   virtual ~IGameState() = default;
 };
 
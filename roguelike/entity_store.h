@@ -0,0 +1,173 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "entities.h"
+#include "intent.h"
+
+// Entities of a map stored column-wise (struct of arrays). Columns are
+// dense and indexed together. Entities are referred by generational
+// handles: a handle keeps its slot while the entity lives, and gets
+// stale once it is removed.
+//
+// Removal is deferred: `kill` only marks an entity dead, so columns
+// stay stable while a turn iterates them. `compact` drops all dead
+// entities in a single sweep.
+//
+// The columns are the state of the entities: objects of a map serve
+// their position and health from here, and Map is the only writer.
+// An object keeps its own fields only until it is added to a map.
+struct EntityStore {
+  using Handle = IGameState::ObjectHandle;
+
+  /* Columns are taken from `resource`. */
+  explicit EntityStore(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : objects{resource},
+        handles{resource},
+        xs{resource},
+        ys{resource},
+        descriptors{resource},
+        health{resource},
+        dead{resource},
+        intents{resource},
+        slots{resource},
+        free_slots{resource} {}
+
+  Handle push(IGameState::Object* object) {
+    uint32_t slot;
+    if (!free_slots.empty()) {
+      slot = free_slots.back();
+      free_slots.pop_back();
+    } else {
+      slot = static_cast<uint32_t>(slots.size());
+      slots.push_back(Slot{});
+    }
+    slots[slot].dense = static_cast<uint32_t>(objects.size());
+    Handle handle{.index = slot, .generation = slots[slot].generation};
+
+    auto [x, y] = object->get_pos();
+    int hp = 0;
+    if (auto healthable = dynamic_cast<IGameState::IHealthable*>(object);
+        healthable != nullptr) {
+      hp = std::get<0>(healthable->get_health());
+    }
+    objects.push_back(object);
+    handles.push_back(handle);
+    xs.push_back(x);
+    ys.push_back(y);
+    descriptors.push_back(object->get_descriptor());
+    health.push_back(hp);
+    dead.push_back(0);
+    intents.push_back(Intent{});
+    return handle;
+  }
+
+  /* Marks an entity dead, it stays in the columns until `compact`.
+   * Returns false if the entity is already dead.
+   */
+  bool kill(Handle handle) {
+    auto i = index(handle);
+    if (dead[i]) {
+      return false;
+    }
+    dead[i] = 1;
+    ++dead_count;
+    return true;
+  }
+
+  // Removes dead entities, keeping the order of the rest.
+  // Handles of removed entities become stale.
+  void compact() {
+    if (dead_count == 0) {
+      return;
+    }
+    uint32_t j = 0;
+    for (uint32_t i = 0; i < objects.size(); ++i) {
+      auto slot = handles[i].index;
+      if (dead[i]) {
+        ++slots[slot].generation;
+        free_slots.push_back(slot);
+        continue;
+      }
+      if (i != j) {
+        objects[j] = objects[i];
+        handles[j] = handles[i];
+        xs[j] = xs[i];
+        ys[j] = ys[i];
+        descriptors[j] = descriptors[i];
+        health[j] = health[i];
+        dead[j] = 0;
+        intents[j] = intents[i];
+      }
+      slots[slot].dense = j++;
+    }
+    objects.resize(j);
+    handles.resize(j);
+    xs.resize(j);
+    ys.resize(j);
+    descriptors.resize(j);
+    health.resize(j);
+    dead.resize(j);
+    intents.resize(j);
+    dead_count = 0;
+  }
+
+  /* Entity was not removed yet, it may be dead though. */
+  bool alive(Handle handle) const {
+    return handle.index < slots.size() &&
+           slots[handle.index].generation == handle.generation;
+  }
+
+  bool is_dead(Handle handle) const { return dead[index(handle)]; }
+
+  size_t pending() const { return dead_count; }
+
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  /* Position of an entity in the columns, `NONE` if it was removed. */
+  uint32_t find(Handle handle) const {
+    return alive(handle) ? slots[handle.index].dense : NONE;
+  }
+
+  /* Position of an alive entity in the columns. */
+  uint32_t index(Handle handle) const {
+    assert(alive(handle));
+    return slots[handle.index].dense;
+  }
+
+  /* Object by handle, nullptr if it is dead or removed. */
+  IGameState::Object* get(Handle handle) const {
+    if (!alive(handle)) {
+      return nullptr;
+    }
+    auto i = slots[handle.index].dense;
+    return dead[i] ? nullptr : objects[i];
+  }
+
+  size_t size() const { return objects.size(); }
+
+  std::pmr::vector<IGameState::Object*> objects;
+  std::pmr::vector<Handle> handles;
+  std::pmr::vector<int> xs;
+  std::pmr::vector<int> ys;
+  std::pmr::vector<IGameState::ObjectDescriptor> descriptors;
+  /* Current health, zero for objects without health. */
+  std::pmr::vector<int> health;
+  /* Tombstones, non-zero for entities killed during the turn. */
+  std::pmr::vector<uint8_t> dead;
+  /* Intents of mobs for the current round, see `DecisionTreeMob::tick`. */
+  std::pmr::vector<Intent> intents;
+
+ private:
+  struct Slot {
+    uint32_t dense{};
+    uint32_t generation{};
+  };
+
+  std::pmr::vector<Slot> slots;
+  std::pmr::vector<uint32_t> free_slots;
+  size_t dead_count = 0;
+};
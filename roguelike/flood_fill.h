@@ -0,0 +1,125 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "bfs.h"
+#include "grid.h"
+#include "region.h"
+
+// Flood fill on bit-packed rows, bounded by a Manhattan radius. The
+// window around the origin is kept as rows of 64-bit words; a step
+// grows the reached set by one tile in each direction with shifts and
+// ORs, and cuts it by the free tiles of the diamond with an AND. Fills
+// of radius r take a few word operations per row and step instead of
+// a queue operation per tile.
+struct BitFlood {
+  // Tiles reachable from (x, y) through free tiles which are not
+  // further than `d` from (x, y), including the origin.
+  Region run(BitGridView obstacles, int x, int y, int d) {
+    Region area;
+    run(obstacles, x, y, d, area);
+    return area;
+  }
+
+  // Same, into `area`. Scratch rows and the storage of `area` are
+  // reused, so once they have grown to the radius, a run does not
+  // allocate.
+  void run(BitGridView obstacles, int x, int y, int d, Region& area) {
+    const int size = 2 * d + 1;
+    lx = x - d;
+    ly = y - d;
+    rows = size;
+    stride = (static_cast<size_t>(size) + 63) / 64;
+    free.assign(rows * stride, 0);
+    reached.assign(rows * stride, 0);
+    next.assign(rows * stride, 0);
+
+    for (int i = 0; i < size; ++i) {
+      /* Row of the diamond: |dy| <= d - |dx|. */
+      int half = d - std::abs(i - d);
+      load_free(obstacles, i, d - half, d + half);
+    }
+    reached[static_cast<size_t>(d) * stride + static_cast<size_t>(d) / 64] |=
+        uint64_t{1} << (d % 64);
+
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < stride; ++j) {
+          uint64_t grown = word(i, j) | (word(i, j) << 1) |
+                           (word(i, j) >> 1);
+          if (j > 0) {
+            grown |= word(i, j - 1) >> 63;
+          }
+          if (j + 1 < stride) {
+            grown |= word(i, j + 1) << 63;
+          }
+          if (i > 0) {
+            grown |= word(i - 1, j);
+          }
+          if (i + 1 < rows) {
+            grown |= word(i + 1, j);
+          }
+          uint64_t current = word(i, j);
+          uint64_t result = current | (grown & free[i * stride + j]);
+          next[i * stride + j] = result;
+          changed |= result != current;
+        }
+      }
+      reached.swap(next);
+    }
+
+    area.reset(lx, ly, size, size);
+    for (size_t i = 0; i < rows; ++i) {
+      for (size_t j = 0; j < stride; ++j) {
+        area.insert_word(static_cast<int>(i), j, word(i, j));
+      }
+    }
+  }
+
+ private:
+  uint64_t word(size_t i, size_t j) const { return reached[i * stride + j]; }
+
+  /* Marks free tiles of row `i` with window columns in [from, to]. */
+  void load_free(BitGridView obstacles, int i, int from, int to) {
+    int x = lx + static_cast<int>(i);
+    for (size_t j = 0; j < stride; ++j) {
+      int lo = std::max(from, static_cast<int>(j * 64));
+      int hi = std::min(to, static_cast<int>(j * 64) + 63);
+      if (lo > hi) {
+        continue;
+      }
+      /* Window bits are not aligned with chunk rows, glue two of them. */
+      int y = ly + static_cast<int>(j * 64);
+      int shift = y & CHUNK_MASK;
+      uint64_t blocked = obstacles.row(x, y) >> shift;
+      if (shift != 0) {
+        blocked |= obstacles.row(x, y + CHUNK_SIZE) << (CHUNK_SIZE - shift);
+      }
+      int l = lo - static_cast<int>(j * 64);
+      int h = hi - static_cast<int>(j * 64);
+      uint64_t range = (h == 63 ? ~uint64_t{0} : (uint64_t{1} << (h + 1)) - 1) &
+                       ~((uint64_t{1} << l) - 1);
+      free[i * stride + j] = ~blocked & range;
+    }
+  }
+
+  int lx = 0, ly = 0;
+  size_t rows = 0, stride = 0;
+  /* Scratch rows, kept between runs. */
+  std::vector<uint64_t> free;
+  std::vector<uint64_t> reached;
+  std::vector<uint64_t> next;
+};
+
+/* Scalar reference of `BitFlood::run`, a tile by tile search. */
+inline Region flood_fill_reference(BitGridView obstacles, int x, int y,
+                                   int d) {
+  FlatBfs bfs;
+  Region area{x - d, y - d, 2 * d + 1, 2 * d + 1};
+  bfs.run(obstacles, x, y, d, [&](int xx, int yy) { area.insert(xx, yy); });
+  return area;
+}
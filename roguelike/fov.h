@@ -0,0 +1,81 @@
+#pragma once
+#include "grid.h"
+#include "region.h"
+
+// Field of view by recursive shadowcasting. Each of the eight octants
+// is scanned row by row outwards from the origin, obstacles cast
+// shadows which are skipped as whole slope intervals.
+struct FieldOfView {
+  /* Tiles seen from (x, y) within the square of `radius` around it. */
+  void build(BitGridView obstacles, int x, int y, int radius) {
+    ox = x;
+    oy = y;
+    r = radius;
+    seen = Region{x - radius, y - radius, 2 * radius + 1, 2 * radius + 1};
+    seen.insert(x, y);
+    /* Transforms of an octant into the map, see `cast`. */
+    const int mult[4][8] = {{1, 0, 0, -1, -1, 0, 0, 1},
+                            {0, 1, -1, 0, 0, -1, 1, 0},
+                            {0, 1, 1, 0, 0, -1, -1, 0},
+                            {1, 0, 0, 1, -1, 0, 0, -1}};
+    for (int i = 0; i < 8; ++i) {
+      cast(obstacles, 1, 1.0, 0.0, mult[0][i], mult[1][i], mult[2][i],
+           mult[3][i]);
+    }
+  }
+
+  bool visible(int x, int y) const { return seen.contains(x, y); }
+
+  int origin_x() const { return ox; }
+  int origin_y() const { return oy; }
+  int radius() const { return r; }
+
+ private:
+  // Lights the rows starting from `row` between slopes `start` and
+  // `end` of the octant. Octant coordinates (dx, dy) go to the map
+  // as (dx * xx + dy * xy, dx * yx + dy * yy).
+  void cast(BitGridView obstacles, int row, double start, double end, int xx,
+            int xy, int yx, int yy) {
+    if (start < end) {
+      return;
+    }
+    double next_start = start;
+    for (int j = row; j <= r; ++j) {
+      int dy = -j;
+      bool blocked = false;
+      for (int dx = -j; dx <= 0; ++dx) {
+        int x = ox + dx * xx + dy * xy;
+        int y = oy + dx * yx + dy * yy;
+        double l_slope = (dx - 0.5) / (dy + 0.5);
+        double r_slope = (dx + 0.5) / (dy - 0.5);
+        if (start < r_slope) {
+          continue;
+        }
+        if (end > l_slope) {
+          break;
+        }
+        seen.insert(x, y);
+        bool opaque = obstacles.test(x, y);
+        if (blocked) {
+          if (opaque) {
+            next_start = r_slope;
+            continue;
+          }
+          blocked = false;
+          start = next_start;
+        } else if (opaque && j < r) {
+          blocked = true;
+          cast(obstacles, j + 1, start, l_slope, xx, xy, yx, yy);
+          next_start = r_slope;
+        }
+      }
+      if (blocked) {
+        break;
+      }
+    }
+  }
+
+  int ox{}, oy{};
+  int r = -1;
+  Region seen;
+};
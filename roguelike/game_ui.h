@@ -3,7 +3,6 @@
 #include <locale.h>
 
 #include <algorithm>
-#include <set>
 #include <sstream>
 #include <thread>
 #include <unordered_map>
@@ -78,13 +77,8 @@ void deinit_UI() { endwin(); }
 
 #define OBJECT_DESCRIPTOR_LIST(_) \
   _(IGameState::ObjectDescriptor::PLAYER, 'p', "player"),\
-  _(IGameState::ObjectDescriptor::WALL, '*', "wall"),\
   _(IGameState::ObjectDescriptor::CHEST, '@', "chest"),\
-  _(IGameState::ObjectDescriptor::STONE, '#', "stone"),\
   _(IGameState::ObjectDescriptor::ENTER, '\0', "enter"),\
-  _(IGameState::ObjectDescriptor::HORIZONTAL_BORDER, '-', "nil"),\
-  _(IGameState::ObjectDescriptor::VERTICAL_BORDER, '|', "nil"),\
-  _(IGameState::ObjectDescriptor::CORNER, '+', "nil"),\
   _(IGameState::ObjectDescriptor::EXIT, '%', "exit"),\
   _(IGameState::ObjectDescriptor::ORC, 'O', "orc"),\
   _(IGameState::ObjectDescriptor::BAT, 'B', "bat"),\
@@ -96,6 +90,19 @@ const std::unordered_map<IGameState::ObjectDescriptor, char>
 const std::unordered_map<IGameState::ObjectDescriptor, std::string>
   OBJECT_DESCRIPTOR_INFO = MAP_INIT_LIST(OBJECT_DESCRIPTOR_LIST, INFO_MAP_MEMBER);
 
+#define TERRAIN_LIST(_) \
+  _(IGameState::Terrain::WALL, '*', "wall"),\
+  _(IGameState::Terrain::STONE, '#', "stone"),\
+  _(IGameState::Terrain::HORIZONTAL_BORDER, '-', "nil"),\
+  _(IGameState::Terrain::VERTICAL_BORDER, '|', "nil"),\
+  _(IGameState::Terrain::CORNER, '+', "nil"),\
+
+const std::unordered_map<IGameState::Terrain, char>
+  TERRAIN_CHAR = MAP_INIT_LIST(TERRAIN_LIST, CHAR_MAP_MEMBER);
+
+const std::unordered_map<IGameState::Terrain, std::string>
+  TERRAIN_INFO = MAP_INIT_LIST(TERRAIN_LIST, INFO_MAP_MEMBER);
+
 #define ITEM_DESCRIPTOR_LIST(_) \
   _(IGameState::ItemDescriptor::SALVE, '&', "salve"),\
   _(IGameState::ItemDescriptor::STICK, '/', "stick"),\
@@ -136,7 +143,7 @@ std::string make_object_info(IGameState::Object *object) {
   if (desc == IGameState::ObjectDescriptor::ITEM) {
     auto as_item_object = dynamic_cast<ItemObject *>(object);
     assert(as_item_object);
-    auto item_desc = as_item_object->get_item()->get_descriptor();
+    auto item_desc = as_item_object->get_item_descriptor();
     auto it = ITEM_DESCRIPTOR_INFO.find(item_desc);
     assert(it != ITEM_DESCRIPTOR_INFO.end());
     ss << it->second;
@@ -162,6 +169,15 @@ std::string make_object_info(IGameState::Object *object) {
   return ss.str();
 }
 
+std::string make_terrain_info(IGameState::Terrain terrain, int x, int y) {
+  auto it = TERRAIN_INFO.find(terrain);
+  assert(it != TERRAIN_INFO.end());
+  std::stringstream ss;
+  ss << it->second << " { pos = (" << std::to_string(x) << ", "
+     << std::to_string(y) << ") }";
+  return ss.str();
+}
+
 struct GameUI {
   GameUI(std::shared_ptr<const IGameState> state) : state(std::move(state)) {}
 
@@ -169,7 +185,7 @@ struct GameUI {
     safe_call(erase);
     previous_object =
       ((under_carriage.type == UnderCarriage::Type::OBJECT) ?
-       under_carriage.object : nullptr);
+       under_carriage.object : IGameState::ObjectHandle{});
     under_carriage.type = UnderCarriage::Type::NONE;
     int header_end_x = draw_header();
     /* Leave place for current object description. */
@@ -181,7 +197,10 @@ struct GameUI {
     refresh();
   }
 
-  Event next() {
+  // Waits for the next event. Meanwhile `idle()` runs slices of
+  // deferred work, it returns false when none is left.
+  template <typename Idle>
+  Event next(Idle&& idle) {
     if (state->is_win()) {
       return SystemEvent{.type = SystemEventType::Win};
     }
@@ -190,7 +209,15 @@ struct GameUI {
     }
     while (true) {
       flushinp();
+      nodelay(stdscr, true);
       auto c = getch();
+      while (c == ERR && idle()) {
+        c = getch();
+      }
+      nodelay(stdscr, false);
+      if (c == ERR) {
+        c = getch();
+      }
       switch (c) {
         /* Internal UI events. */
         case KEY_LEFT:
@@ -275,7 +302,12 @@ struct GameUI {
     move(start_x, 0);
     printw("Obj:    ");
     if (under_carriage.type == UnderCarriage::Type::OBJECT)
-      printw("%s\n", make_object_info(under_carriage.object).data());
+      printw("%s\n",
+             make_object_info(state->get_object(under_carriage.object)).data());
+    else if (under_carriage.type == UnderCarriage::Type::TERRAIN)
+      printw("%s\n", make_terrain_info(under_carriage.terrain.tile,
+                                       under_carriage.terrain.x,
+                                       under_carriage.terrain.y).data());
     else if (under_carriage.type == UnderCarriage::Type::ITEM) {
       auto player = dynamic_cast<Player *>(state->get_player());
       auto item = player->get_stash()[under_carriage.item_pos].get();
@@ -343,7 +375,7 @@ struct GameUI {
       case IGameState::ObjectDescriptor::ITEM: {
         auto as_item_object = dynamic_cast<ItemObject *>(obj);
         assert(as_item_object);
-        auto item_desc = as_item_object->get_item()->get_descriptor();
+        auto item_desc = as_item_object->get_item_descriptor();
         auto it = ITEM_DESCRIPTOR_CHAR.find(item_desc);
         assert(it != ITEM_DESCRIPTOR_CHAR.end());
         return it->second;
@@ -372,93 +404,91 @@ struct GameUI {
     }
     previous_location = map.name;
 
+    /* Ask the map for objects in a visual field only.
+     * The player comes last to be drawn over the objects it stands on.
+     */
+    visible_handles.clear();
+    state->query_rect(lx, ly, ux, uy, visible_handles);
+    visible.clear();
+    for (auto handle : visible_handles) {
+      visible.push_back({state->get_object(handle), handle});
+    }
+
     //auto previous_object =
     //    ((under_carriage.type == UnderCarriage::Type::OBJECT) ?
     //    under_carriage.object : nullptr);
     //under_carriage.type = UnderCarriage::Type::NONE;
     //under_carriage.object = nullptr;
-    for (const auto &object : map.objects) {
+    for (const auto &[object, handle] : visible) {
       auto [x, y] = object->get_pos();
-      /* Check that object is contained in a visual field. */
-      if (lx <= x && x < ux && ly <= y && y < uy) {
-        auto descriptor = object->get_descriptor();
-        x = rem(x, H_FIELD - 2) + 1;
-        y = rem(y, W_FIELD - 2) + 1;
+      auto descriptor = object->get_descriptor();
+      x = rem(x, H_FIELD - 2) + 1;
+      y = rem(y, W_FIELD - 2) + 1;
+
+      if (descriptor == IGameState::ObjectDescriptor::PLAYER &&
+          set_carriage_to_player) {
+        carriage_x = start_x + x;
+        carriage_y = y;
+      }
+      if (carriage_pinned && handle == previous_object) {
+        carriage_x = start_x + x;
+        carriage_y = y;
+      }
+      if (carriage_x == start_x + x && carriage_y == y) {
+        /* Remember current object. */
+        under_carriage.type = UnderCarriage::Type::OBJECT;
+        under_carriage.object = handle;
+      }
+    }
 
-        if (descriptor == IGameState::ObjectDescriptor::PLAYER &&
-            set_carriage_to_player) {
-          carriage_x = start_x + x;
-          carriage_y = y;
-        }
-        if (carriage_pinned && object == previous_object) {
-          carriage_x = start_x + x;
-          carriage_y = y;
-        }
-        if (carriage_x == start_x + x && carriage_y == y) {
-          /* Remember current object. */
-          under_carriage.type = UnderCarriage::Type::OBJECT;
-          under_carriage.object = object;
-        }
+    /* Objects stand on terrain, so it is under the carriage only
+     * if there is no object.
+     */
+    if (under_carriage.type == UnderCarriage::Type::NONE &&
+        carriage_x > start_x && carriage_x < start_x + H_FIELD - 1 &&
+        carriage_y > 0 && carriage_y < W_FIELD - 1) {
+      int x = lx + carriage_x - start_x - 1;
+      int y = ly + carriage_y - 1;
+      auto tile = state->get_terrain(x, y);
+      if (tile != IGameState::Terrain::NONE) {
+        under_carriage.type = UnderCarriage::Type::TERRAIN;
+        under_carriage.terrain = {.tile = tile, .x = x, .y = y};
       }
     }
 
     /* Second pass, draw a field. */
     int attack_field_color_pair_shift = 0;
-    std::set<std::pair<int, int>> attack_area;
+    attack_area.clear();
     if (under_carriage.type == UnderCarriage::Type::OBJECT) {
-        if (under_carriage.object == static_cast<IGameState::Object *>(player)) {
-            attack_area = player->get_attack_area();
+        if (under_carriage.object == IGameState::PLAYER_HANDLE) {
+            player->get_attack_area(attack_area);
             attack_field_color_pair_shift = BLUE_SHIFT;
-        } else if (auto mob = dynamic_cast<IGameState::IMob *>(under_carriage.object);
+        } else if (auto mob = dynamic_cast<IGameState::IMob *>(
+                       state->get_object(under_carriage.object));
             mob != nullptr) {
-            attack_area = mob->get_attack_area();
+            mob->get_attack_area(attack_area);
             attack_field_color_pair_shift = RED_SHIFT;
         }
     }
 
-    for (const auto &object : map.objects) {
-      auto [x, y] = object->get_pos();
-      /* Check that object is contained in a visual field. */
-      if (lx <= x && x < ux && ly <= y && y < uy) {
-        auto descriptor = object->get_descriptor();
-        bool in_attack_area = attack_area.find({x, y}) != attack_area.end();
-        if (in_attack_area) {
-          attack_area.erase({x, y});
+    for (int x = lx; x < ux; ++x) {
+      for (int y = ly; y < uy; ++y) {
+        auto tile = state->get_terrain(x, y);
+        if (tile == IGameState::Terrain::NONE) {
+          continue;
         }
-
-        x = rem(x, H_FIELD - 2) + 1;
-        y = rem(y, W_FIELD - 2) + 1;
-        auto symbol = make_object_char(object);
-        int attr = 0;
-        switch (descriptor) {
-          case IGameState::ObjectDescriptor::ENTER: {
-            attr =
-                COLOR_PAIR(3 + attack_field_color_pair_shift * in_attack_area);
-            break;
-          }
-          case IGameState::ObjectDescriptor::ORC: {
-            attr =
-                COLOR_PAIR(4 + attack_field_color_pair_shift * in_attack_area);
-            break;
-          }
-          case IGameState::ObjectDescriptor::BAT: {
-            attr =
-                COLOR_PAIR(5 + attack_field_color_pair_shift * in_attack_area);
-            break;
-          }
-          default: {
-            attr =
-                COLOR_PAIR(1 + attack_field_color_pair_shift * in_attack_area);
-            break;
-          }
-        }
-        attron(attr);
-        mvaddch(start_x + x, y, symbol);
-        attroff(attr);
+        auto it = TERRAIN_CHAR.find(tile);
+        assert(it != TERRAIN_CHAR.end());
+        attron(COLOR_PAIR(1));
+        mvaddch(start_x + rem(x, H_FIELD - 2) + 1, rem(y, W_FIELD - 2) + 1,
+                it->second);
+        attroff(COLOR_PAIR(1));
       }
     }
-    for (auto [x, y] : attack_area) {
-      /* Check that object is contained in a visual field. */
+
+    /* Attack area goes first, objects are drawn over it. */
+    attack_area.for_each([&](int x, int y) {
+      /* Check that tile is contained in a visual field. */
       if (lx <= x && x < ux && ly <= y && y < uy) {
         x = rem(x, H_FIELD - 2) + 1;
         y = rem(y, W_FIELD - 2) + 1;
@@ -467,6 +497,42 @@ struct GameUI {
         mvaddch(start_x + x, y, symbol);
         attroff(COLOR_PAIR(1 + attack_field_color_pair_shift));
       }
+    });
+
+    for (const auto &[object, handle] : visible) {
+      auto [x, y] = object->get_pos();
+      auto descriptor = object->get_descriptor();
+      bool in_attack_area = attack_area.contains(x, y);
+
+      x = rem(x, H_FIELD - 2) + 1;
+      y = rem(y, W_FIELD - 2) + 1;
+      auto symbol = make_object_char(object);
+      int attr = 0;
+      switch (descriptor) {
+        case IGameState::ObjectDescriptor::ENTER: {
+          attr =
+              COLOR_PAIR(3 + attack_field_color_pair_shift * in_attack_area);
+          break;
+        }
+        case IGameState::ObjectDescriptor::ORC: {
+          attr =
+              COLOR_PAIR(4 + attack_field_color_pair_shift * in_attack_area);
+          break;
+        }
+        case IGameState::ObjectDescriptor::BAT: {
+          attr =
+              COLOR_PAIR(5 + attack_field_color_pair_shift * in_attack_area);
+          break;
+        }
+        default: {
+          attr =
+              COLOR_PAIR(1 + attack_field_color_pair_shift * in_attack_area);
+          break;
+        }
+      }
+      attron(attr);
+      mvaddch(start_x + x, y, symbol);
+      attroff(attr);
     }
   }
 
@@ -489,13 +555,25 @@ struct GameUI {
           NONE,
           ITEM,
           OBJECT,
+          TERRAIN,
       };
       Type type;
       union {
           int item_pos;
-          IGameState::Object *object;
+          IGameState::ObjectHandle object{};
+          struct {
+              IGameState::Terrain tile;
+              int x, y;
+          } terrain;
       };
   } under_carriage;
 
-  IGameState::Object *previous_object;
+  IGameState::ObjectHandle previous_object;
+
+  /* Objects in a visual field, kept between draws. */
+  std::vector<IGameState::ObjectHandle> visible_handles;
+  std::vector<std::pair<IGameState::Object *, IGameState::ObjectHandle>>
+      visible;
+  /* Attack area under the carriage, kept between draws. */
+  Region attack_area;
 };
@@ -0,0 +1,131 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_map>
+
+/* Tiles are stored in square chunks, which are allocated on the first
+ * write. Memory is proportional to the area actually used, so huge and
+ * sparse generated maps (negative coordinates too) are fine.
+ */
+const int CHUNK_SHIFT = 6;
+const int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+const int CHUNK_MASK = CHUNK_SIZE - 1;
+
+// Key of the chunk which contains tile (x, y).
+inline uint64_t chunk_key(int x, int y) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(x >> CHUNK_SHIFT))
+          << 32) |
+         static_cast<uint32_t>(y >> CHUNK_SHIFT);
+}
+
+struct ChunkKeyHash {
+  size_t operator()(uint64_t key) const {
+    /* Chunk coordinates are small, mix them (murmur3 finalizer). */
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return static_cast<size_t>(key);
+  }
+};
+
+// 2D array of tiles addressed by map coordinates. Chunks are taken
+// from `resource`.
+template <typename T>
+struct Grid {
+  explicit Grid(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : chunks{resource} {}
+
+  // Value of the tile, default value if the tile was never touched.
+  T get(int x, int y) const {
+    auto it = chunks.find(chunk_key(x, y));
+    if (it == chunks.end()) {
+      return T{};
+    }
+    return it->second[index(x, y)];
+  }
+
+  // Mutable tile, allocates its chunk if needed.
+  T& at(int x, int y) { return chunks[chunk_key(x, y)][index(x, y)]; }
+
+  // Calls `f(x, y, value)` for each tile which is not default.
+  template <typename F>
+  void for_each(F&& f) const {
+    for (const auto& [key, chunk] : chunks) {
+      int cx = static_cast<int32_t>(key >> 32) * CHUNK_SIZE;
+      int cy = static_cast<int32_t>(key & UINT32_MAX) * CHUNK_SIZE;
+      for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; ++i) {
+        if (chunk[i] != T{}) {
+          f(cx + (i >> CHUNK_SHIFT), cy + (i & CHUNK_MASK), chunk[i]);
+        }
+      }
+    }
+  }
+
+  size_t chunk_count() const { return chunks.size(); }
+
+  using Chunk = std::array<T, CHUNK_SIZE * CHUNK_SIZE>;
+
+ private:
+  static size_t index(int x, int y) {
+    return static_cast<size_t>(((x & CHUNK_MASK) << CHUNK_SHIFT) |
+                               (y & CHUNK_MASK));
+  }
+
+  /* Nodes are never moved, chunks are value-initialized. */
+  std::pmr::unordered_map<uint64_t, Chunk, ChunkKeyHash> chunks;
+};
+
+/* Chunk of a bit-packed tile set, a word per row. */
+using BitChunk = std::array<uint64_t, CHUNK_SIZE>;
+using BitChunks = std::pmr::unordered_map<uint64_t, BitChunk, ChunkKeyHash>;
+
+// Read-only view of a bit-packed tile set. Cheap to copy,
+// valid while the underlying `BitGrid` is not changed.
+// Remembers the last chunk, searches are local in practice.
+struct BitGridView {
+  explicit BitGridView(const BitChunks* chunks) : chunks{chunks} {}
+
+  bool test(int x, int y) const {
+    return (row(x, y) >> (y & CHUNK_MASK)) & 1;
+  }
+
+  // Bits of the chunk row which contains (x, y).
+  uint64_t row(int x, int y) const {
+    auto key = chunk_key(x, y);
+    if (key != last_key || last == nullptr) {
+      auto it = chunks->find(key);
+      if (it == chunks->end()) {
+        return 0;
+      }
+      last_key = key;
+      last = &it->second;
+    }
+    return (*last)[x & CHUNK_MASK];
+  }
+
+ private:
+  const BitChunks* chunks;
+  mutable uint64_t last_key{};
+  mutable const BitChunk* last{};
+};
+
+// Bit-packed set of tiles, one bit per tile.
+struct BitGrid {
+  explicit BitGrid(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : chunks{resource} {}
+
+  void set(int x, int y) {
+    chunks[chunk_key(x, y)][x & CHUNK_MASK] |= uint64_t{1} << (y & CHUNK_MASK);
+  }
+
+  void clear() { chunks.clear(); }
+
+  BitGridView view() const { return BitGridView{&chunks}; }
+
+ private:
+  BitChunks chunks;
+};
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+
+// What a mob does this turn. Actions only choose it, looking at the
+// map as it was at the start of the turn; it is applied afterwards.
+struct Intent {
+  enum class Kind : uint8_t { STAY, MOVE, ATTACK };
+
+  Kind kind = Kind::STAY;
+  /* Target tile of a move. */
+  int x = 0, y = 0;
+  /* Damage to the player of an attack. */
+  int damage = 0;
+};
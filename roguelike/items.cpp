@@ -1,5 +1,6 @@
 #include "items.h"
 #include "objects.h"
+#include "panic.h"
 
 Salve::Salve(int heal)
   : IGameState::Item{IGameState::ItemDescriptor::SALVE}, heal{heal} {}
@@ -24,4 +25,15 @@ void Stick::apply(IGameState::Object *object) const {
       mob->damage(damage);
     }
   }*/
-}
\ No newline at end of file
+}
+
+std::unique_ptr<IGameState::Item> make_item(
+    IGameState::ItemDescriptor descriptor) {
+  switch (descriptor) {
+    case IGameState::ItemDescriptor::STICK:
+      return std::make_unique<Stick>();
+    default:
+      panic("unexpected item");
+      return nullptr;
+  }
+}
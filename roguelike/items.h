@@ -23,4 +23,8 @@ struct Stick : public GameStateObject, IGameState::Item {
 
     int damage;
     int radius;
-};
\ No newline at end of file
+};
+
+// Payload of a new item of the kind, as generated maps lay it out.
+std::unique_ptr<IGameState::Item> make_item(
+    IGameState::ItemDescriptor descriptor);
\ No newline at end of file
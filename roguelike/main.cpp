@@ -1,4 +1,6 @@
 #include <iostream>
+#include <random>
+#include <string>
 
 #include "app.h"
 
@@ -7,12 +9,26 @@ struct EndWinGuard {
 };
 
 int main(int argc, char *argv[]) {
-  if (argc != 2) {
-    std::cout << "usage: ./app <WORLD_PATH>";
+  const char *usage = "usage: ./app <WORLD_PATH> [SEED]";
+  if (argc != 2 && argc != 3) {
+    std::cout << usage;
     exit(1);
   }
+  /* Games with the same seed are the same. */
+  uint64_t seed = 0;
+  if (argc == 3) {
+    try {
+      seed = std::stoull(argv[2]);
+    } catch (const std::exception &) {
+      std::cout << usage;
+      exit(1);
+    }
+  } else {
+    std::random_device rd;
+    seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+  }
   //auto world = gen_world(15);
-  auto world = std::make_unique<World>(std::filesystem::path{argv[1]});
+  auto world = std::make_unique<World>(std::filesystem::path{argv[1]}, seed);
   init_UI(argc, argv);
   auto guard = EndWinGuard{};
   auto app = App{std::move(world)};
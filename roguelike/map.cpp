@@ -1,22 +1,26 @@
 #include "map.h"
 
 #include <algorithm>
+#include <array>
 #include <filesystem>
 #include <fstream>
 #include <unordered_map>
-#include <random>
+#include <unordered_set>
 
 #include "consts.h"
 #include "entities.h"
 #include "objects.h"
 #include "panic.h"
 #include "items.h"
+#include "rng.h"
 
 /* Map impl. */
-Map::Map(IGameState::Object* player) { objects.push_back(player); }
+Map::Map(IGameState::Object* player) { push_player(player); }
 
 Map::Map() {}
 
+Map::Map(size_t arena_size) : arena{arena_size} {}
+
 Map::Map(const std::filesystem::path& p) {
   std::fstream in(p);
   std::string s;
@@ -27,62 +31,48 @@ Map::Map(const std::filesystem::path& p) {
     for (int y = 0; y < s.size(); ++y) {
       char c = s[y];
       if ('A' <= c && c <= 'Z') {
-        push_new_object(enters, std::move(std::make_unique<Enter>(
-                                    x, y, LEVEL_0_DUNGEON, std::string{c})));
+        push_new_object(enters, arena.make<Enter>(x, y, LEVEL_0_DUNGEON,
+                                                  std::string{c}));
       } else {
         switch (c) {
           case '|': {
-            push_new_object(
-                borders,
-                std::move(std::make_unique<Border>(
-                    x, y, IGameState::ObjectDescriptor::VERTICAL_BORDER)));
+            set_terrain(x, y, IGameState::Terrain::VERTICAL_BORDER);
             break;
           }
           case '+': {
-            push_new_object(borders,
-                            std::move(std::make_unique<Border>(
-                                x, y, IGameState::ObjectDescriptor::CORNER)));
+            set_terrain(x, y, IGameState::Terrain::CORNER);
             break;
           }
           case '-': {
-            push_new_object(
-                borders,
-                std::move(std::make_unique<Border>(
-                    x, y, IGameState::ObjectDescriptor::HORIZONTAL_BORDER)));
+            set_terrain(x, y, IGameState::Terrain::HORIZONTAL_BORDER);
             break;
           }
           case '@': {
-            push_new_object(chests, std::move(std::make_unique<Chest>(x, y)));
+            push_new_object(chests, arena.make<Chest>(x, y));
             break;
           }
           case '*': {
-            push_new_object(dungeon_blocks,
-                            std::move(std::make_unique<DungeonBlock>(
-                                x, y, LEVEL_0_DUNGEON)));
+            set_terrain(x, y, IGameState::Terrain::STONE);
             break;
           }
           case '%': {
-            push_exit(std::move(std::make_unique<Exit>(x, y)));
+            push_exit(arena.make<Exit>(x, y));
             break;
           }
           case ' ': {
             break;
           }
           case '$': {
-            push_new_object(mobs, std::move(std::unique_ptr<Mob>(
-                                      std::move(std::make_unique<Orc>(x, y)))));
+            push_new_object(mobs, ArenaPtr<Mob>(arena.make<Orc>(x, y)));
             break;
           }
           case '&': {
-            push_new_object(mobs, std::move(std::unique_ptr<Mob>(
-                                      std::move(std::make_unique<Bat>(x, y)))));
+            push_new_object(mobs, ArenaPtr<Mob>(arena.make<Bat>(x, y)));
             break;
           }
           case '/': {
-            auto item = std::unique_ptr<GameState::Item>(
-                            std::move(std::make_unique<Stick>()));
-            push_new_object(items, std::move(std::make_unique<ItemObject>(
-                                      std::move(item), x, y)));
+            push_new_object(items, arena.make<ItemObject>(
+                                       IGameState::ItemDescriptor::STICK, x, y));
             break;
           }
           default: {
@@ -95,40 +85,174 @@ Map::Map(const std::filesystem::path& p) {
   }
 }
 
-void Map::push_player(IGameState::Object* player) { objects.push_back(player); }
+void Map::push_player(IGameState::Object* player) { this->player = player; }
 
-void Map::push_exit(std::unique_ptr<Exit> exit_obj) {
-  objects.push_back(exit_obj.get());
+void Map::push_exit(ArenaPtr<Exit> exit_obj) {
+  exit_obj->owner = this;
+  exit_obj->entity = entities.push(exit_obj.get());
+  auto [x, y] = exit_obj->get_pos();
+  spatial.insert(exit_obj->entity, x, y);
+  occupy(exit_obj.get());
   exit = std::move(exit_obj);
 }
 
+void Map::occupy(const IGameState::Object* obj) {
+  auto [x, y] = obj->get_pos();
+  ++occupancy.at(x, y);
+}
+
+void Map::leave(const IGameState::Object* obj) {
+  auto [x, y] = obj->get_pos();
+  assert(occupancy.get(x, y) > 0);
+  --occupancy.at(x, y);
+}
+
+void Map::set_terrain(int x, int y, IGameState::Terrain tile) {
+  auto& current = terrain.at(x, y);
+  if (current != tile) {
+    current = tile;
+    touch_obstacles();
+  }
+}
+
+IGameState::Terrain Map::get_terrain(int x, int y) const {
+  return terrain.get(x, y);
+}
+
 bool Map::has_object(int x, int y, const IGameState::Object* exclude) const {
-  return std::any_of(objects.begin(), objects.end(),
-    [&](IGameState::Object *obj) {
-      if (obj != exclude) {
-        auto [xo, yo] = obj->get_pos();
-        return (xo == x && yo == y);
+  if (terrain.get(x, y) != IGameState::Terrain::NONE) {
+    return true;
+  }
+  int count = occupancy.get(x, y);
+  if (exclude != nullptr && exclude != player && count > 0) {
+    auto [xe, ye] = exclude->get_pos();
+    count -= (xe == x && ye == y);
+  }
+  if (player != nullptr && player != exclude) {
+    auto [xp, yp] = player->get_pos();
+    count += (xp == x && yp == y);
+  }
+  return count > 0;
+}
+
+bool Map::is_blocked(int x, int y) const {
+  if (terrain.get(x, y) != IGameState::Terrain::NONE) {
+    return true;
+  }
+  if (occupancy.get(x, y) > crowd.get(x, y)) {
+    return true;
+  }
+  if (player == nullptr) {
+    return false;
+  }
+  auto [xp, yp] = player->get_pos();
+  return xp == x && yp == y;
+}
+
+BitGridView Map::get_obstacles() const {
+  if (obstacles_dirty) {
+    build_obstacles();
+    obstacles_dirty = false;
+  }
+  return obstacles.view();
+}
+
+/* Appends a path from the end of `path` to `to`, which share an area
+ * of the room graph. Tries both straight L-shaped paths first.
+ */
+bool append_leg(BitGridView obstacles, std::vector<Pathfinder::Cell>& path,
+                Pathfinder::Cell to) {
+  auto from = path.back();
+  auto straight = [&](bool x_first) {
+    auto c = from;
+    size_t size = path.size();
+    while (!(c == to)) {
+      if (x_first ? c.x != to.x : c.y == to.y) {
+        c.x += (to.x > c.x) - (to.x < c.x);
+      } else {
+        c.y += (to.y > c.y) - (to.y < c.y);
       }
-      return false;
+      if (obstacles.test(c.x, c.y)) {
+        path.resize(size);
+        return false;
+      }
+      path.push_back(c);
+    }
+    return true;
+  };
+  if (straight(true) || straight(false)) {
+    return true;
+  }
+  thread_local std::vector<Pathfinder::Cell> leg;
+  int radius = std::max(std::abs(to.x - from.x), std::abs(to.y - from.y)) + 2;
+  if (!shared_pathfinder().find(obstacles, from.x, from.y, to.x, to.y, radius,
+                                leg)) {
+    return false;
+  }
+  path.insert(path.end(), leg.begin() + 1, leg.end());
+  return true;
+}
+
+bool Map::find_path(int sx, int sy, int tx, int ty, int radius,
+                    std::vector<Pathfinder::Cell>& path) const {
+  if (std::abs(tx - sx) + std::abs(ty - sy) > radius) {
+    return false;
+  }
+  auto obstacles = get_obstacles();
+  thread_local std::vector<Pathfinder::Cell> waypoints;
+  if (!rooms.empty() && rooms.route({sx, sy}, {tx, ty}, waypoints)) {
+    path.assign(1, {sx, sy});
+    bool ok = true;
+    for (auto waypoint : waypoints) {
+      ok = ok && append_leg(obstacles, path, waypoint);
     }
-  );
+    if (ok) {
+      return true;
+    }
+  }
+  return shared_pathfinder().find(obstacles, sx, sy, tx, ty, radius, path);
 }
 
-std::set<std::pair<int, int>> Map::get_obstacles() const {
-  std::set<std::pair<int, int>> obstacles;
+bool Map::can_see(int from_x, int from_y, int x, int y) const {
+  if (view.radius() != VIEW_RADIUS || view_version != version ||
+      view.origin_x() != from_x || view.origin_y() != from_y) {
+    view.build(get_obstacles(), from_x, from_y, VIEW_RADIUS);
+    view_version = version;
+  }
+  return view.visible(x, y);
+}
 
-#define run_over(objs)            \
-  for (const auto& obj : objs) {  \
-    auto [x, y] = obj->get_pos(); \
-    obstacles.insert({x, y});     \
+void Map::build_obstacles() const {
+  obstacles.clear();
+  terrain.for_each(
+      [&](int x, int y, IGameState::Terrain) { obstacles.set(x, y); });
+  for (const auto& chest : chests) {
+    /* Destroyed ones stay in the container until `compact`. */
+    if (is_destroyed(chest.get())) {
+      continue;
+    }
+    auto [x, y] = chest->get_pos();
+    obstacles.set(x, y);
   }
+}
 
-  run_over(walls);
-  run_over(dungeon_blocks);
-  run_over(borders);
-  run_over(chests);
+void Map::compact() {
+  if (entities.pending() == 0) {
+    return;
+  }
+  entities.compact();
+  sweep(enters);
+  sweep(chests);
+  sweep(mobs);
+  sweep(items);
+}
 
-  return obstacles;
+void Map::seed(uint64_t seed) {
+  for (size_t i = 0; i < mobs.size(); ++i) {
+    if (auto mob = dynamic_cast<DecisionTreeMob*>(mobs[i].get())) {
+      mob->seed(stream_seed(seed, i));
+    }
+  }
 }
 
 std::tuple<int, int> Map::start_pos() const { assert(exit != nullptr); return exit->get_pos(); }
@@ -137,7 +261,8 @@ std::tuple<int, int> Map::start_pos() const { assert(exit != nullptr); return ex
 /* World impl. */
 
 // Loads a world from directory.
-World::World(const std::filesystem::path& dir) : dir(dir) {
+World::World(const std::filesystem::path& dir, uint64_t seed)
+    : dir(dir), seed(seed) {
   // Collect all maps by name.
   std::vector<std::unique_ptr<Map>> maps;
   std::unordered_map<std::string, Map*> map_by_name;
@@ -147,6 +272,8 @@ World::World(const std::filesystem::path& dir) : dir(dir) {
     }
     if (file.path().extension() == ".rl") {
       maps.push_back(std::make_unique<Map>(file.path()));
+      /* Streams of a map depend on its name, not on the order of files. */
+      maps.back()->seed(stream_seed(seed, stream_id(maps.back()->name)));
       map_by_name.insert({file.path().stem().string(), maps.back().get()});
     }
   }
@@ -175,25 +302,32 @@ World::World(const std::filesystem::path& dir) : dir(dir) {
   this->start_map = start_map;
 }
 
-int inline gen_int(std::mt19937 &gen, int l, int r) {
-  return l + (int)((unsigned long)gen() % (r - l + 1));
+int inline gen_int(Xoshiro256 &gen, int l, int r) {
+  return uniform_int(gen, l, r);
 }
 
-plan gen_plan(int n) {
-  std::random_device rd;
-  std::mt19937 gen(rd());
-  std::vector<int> p(2 * n - 1, 1);
-  for (int i = 2; i < 2 * n - 1; i++)
-    p[i] = p[i - 1] << 1;
+/* Index in [0, count) with weights 1, 1, 2, 4, ..., 2^(count - 2):
+ * the last index has half of the mass, the one before a quarter and
+ * so on, so the count of trailing zeros of a draw picks it.
+ */
+int gen_doubling(Xoshiro256 &gen, int count) {
+  uint64_t draw = gen();
+  int zeros = draw == 0 ? 64 : __builtin_ctzll(draw);
+  return zeros < count - 1 ? count - 1 - zeros : 0;
+}
 
-  std::discrete_distribution<> d(p.begin(), p.end());
+plan gen_plan(int n, Xoshiro256 &gen, std::pmr::memory_resource *scratch) {
 
-  std::vector<plan_node> nodes(n);
+  std::pmr::vector<plan_node> nodes(n, scratch);
   nodes[0] = plan_node(0, 0);
 
   const int shift = n - 1;
   int global_minmax[2][2] = {{shift, shift}, {shift, shift}};
-  std::vector<std::pair<int, int>> minmax[2][2];
+  std::pmr::vector<std::pair<int, int>> minmax[2][2] = {
+    {std::pmr::vector<std::pair<int, int>>(scratch),
+     std::pmr::vector<std::pair<int, int>>(scratch)},
+    {std::pmr::vector<std::pair<int, int>>(scratch),
+     std::pmr::vector<std::pair<int, int>>(scratch)}};
   for (auto &comp : minmax) {
     comp[0].assign(2 * n - 1, std::make_pair(INT32_MAX, 0));
     comp[1].assign(2 * n - 1, std::make_pair(INT32_MIN, 0));
@@ -210,7 +344,11 @@ plan gen_plan(int n) {
     auto &minmax1 = minmax[comp1][direct1_idx][coord0];
     auto &global_minmax1 = global_minmax[comp1][direct1_idx];
     int max_delta = std::abs(global_minmax1 - minmax1.first);
-    int delta1 = std::min(d(gen), max_delta) + 1;
+    /* A tunnel is at most 32 tiles long whatever the count of rooms,
+     * so larger maps get more rooms, not longer corridors.
+     */
+    int doubling = gen_doubling(gen, std::min(2 * n - 1, 32));
+    int delta1 = std::min(doubling, max_delta) + 1;
     int coord1 = minmax1.first + direct1 * delta1;
     coord[comp0] = coord0 - shift;
     coord[comp1] = coord1 - shift;
@@ -255,12 +393,13 @@ plan gen_plan(int n) {
   return plan;
 }
 
-IGameState::ObjectDescriptor border_type[2] = {
-  IGameState::ObjectDescriptor::HORIZONTAL_BORDER,
-  IGameState::ObjectDescriptor::VERTICAL_BORDER,
+IGameState::Terrain border_type[2] = {
+  IGameState::Terrain::HORIZONTAL_BORDER,
+  IGameState::Terrain::VERTICAL_BORDER,
 };
 
-void build_box_from_node(Map &mp, plan_node *node, int box_width, int tunnel_width) {
+template <typename Canvas>
+void build_box_from_node(Canvas &mp, plan_node *node, int box_width, int tunnel_width) {
   int x = node->x, y = node->y;
   int l = box_width - tunnel_width - 1;
   int r = box_width + tunnel_width - 1;
@@ -272,20 +411,19 @@ void build_box_from_node(Map &mp, plan_node *node, int box_width, int tunnel_wid
       int coords[2] = { x, y };
       coords[comp0] += direct0 * box_width;
       coords[comp1] -= direct1 * box_width;
-      mp.push_new_object(mp.borders, std::move(std::make_unique<Border>(
-        coords[0], coords[1], IGameState::ObjectDescriptor::CORNER)));
+      mp.set_terrain(coords[0], coords[1], IGameState::Terrain::CORNER);
       for (int i = 0; i < 2 * box_width - 1; i++) {
         coords[comp1] += direct1;
         if (node->edges[comp1][direct0_idx].dst == -1 || i < l || r < i)
-          mp.push_new_object(mp.borders, std::move(std::make_unique<Border>(
-            coords[0], coords[1], border_type[comp0])));
+          mp.set_terrain(coords[0], coords[1], border_type[comp0]);
       }
     }
   }
 }
 
+template <typename Canvas>
 void build_tunnels_from_node(
-  Map &mp, const plan &plan, int node_idx, int box_width, int tunnel_width) {
+  Canvas &mp, const plan &plan, int node_idx, int box_width, int tunnel_width) {
   int coord[2];
   auto &node = plan.nodes[node_idx];
   for (int comp0 = 0; comp0 < 2; comp0++) {
@@ -296,7 +434,8 @@ void build_tunnels_from_node(
     int neigh_idx = edge.dst;
     if (neigh_idx == -1)
       continue;
-    std::vector<int> intersections(edge.intersections);
+    std::pmr::vector<int> intersections(edge.intersections,
+                                        edge.intersections.get_allocator());
     std::transform(edge.intersections.begin(), edge.intersections.end(),
                    intersections.begin(), [&](int idx) {
       return reinterpret_cast<const int *>(&plan.nodes[idx].x)[comp1];
@@ -325,23 +464,21 @@ void build_tunnels_from_node(
         l = *actual - tunnel_width;
         r = *actual + tunnel_width;
       }
-      IGameState::ObjectDescriptor type = border_type[comp0];
+      IGameState::Terrain type = border_type[comp0];
       if (l == coord1) {
-        type = IGameState::ObjectDescriptor::CORNER;
+        type = IGameState::Terrain::CORNER;
       } else if (r == coord1) {
-        type = IGameState::ObjectDescriptor::CORNER;
+        type = IGameState::Terrain::CORNER;
         actual++;
       }
       if (coord1 <= l || r <= coord1) {
-        //IGameState::ObjectDescriptor type = border_type[comp0];
+        //IGameState::Terrain type = border_type[comp0];
         if (coord1 == from1 || coord1 == to1)
-          type = IGameState::ObjectDescriptor::CORNER;
+          type = IGameState::Terrain::CORNER;
         coord[comp0] = coord0 - tunnel_width;
-        mp.push_new_object(mp.borders, std::move(
-          std::make_unique<Border>(coord[0], coord[1], type)));
+        mp.set_terrain(coord[0], coord[1], type);
         coord[comp0] = coord0 + tunnel_width;
-        mp.push_new_object(mp.borders, std::move(
-          std::make_unique<Border>(coord[0], coord[1], type)));
+        mp.set_terrain(coord[0], coord[1], type);
       }
       coord[comp1] += direct1;
     }
@@ -350,8 +487,90 @@ void build_tunnels_from_node(
   }
 }
 
-std::unique_ptr<Map> gen_map(int n) {
-  auto plan = gen_plan(n);
+/* Keeps rooms and tunnels of the plan as areas of the room graph. */
+void build_room_graph(
+  Map &mp, const plan &plan, int box_width, int tunnel_width) {
+  auto &graph = mp.rooms;
+  const int inner = tunnel_width - 1;
+  auto scratch = plan.nodes.get_allocator();
+  std::pmr::vector<int> room_area(plan.n, scratch);
+  for (int i = 0; i < plan.n; i++) {
+    auto &node = plan.nodes[i];
+    room_area[i] = graph.add_area(node.x - box_width + 1, node.y - box_width + 1,
+                                  node.x + box_width - 1, node.y + box_width - 1);
+  }
+  /* Tunnels run from a node in the positive direction only. */
+  std::pmr::vector<std::array<int, 2>> tunnel_area(plan.n, {-1, -1}, scratch);
+  for (int i = 0; i < plan.n; i++) {
+    auto &node = plan.nodes[i];
+    for (int comp0 = 0; comp0 < 2; comp0++) {
+      int dst = node.edges[comp0][1].dst;
+      if (dst == -1)
+        continue;
+      int comp1 = 1 - comp0;
+      int coord0 = reinterpret_cast<const int *>(&node.x)[comp0];
+      int from1 = reinterpret_cast<const int *>(&node.x)[comp1] + box_width;
+      int to1 =
+        reinterpret_cast<const int *>(&plan.nodes[dst].x)[comp1] - box_width;
+      int lo[2], hi[2];
+      lo[comp0] = coord0 - inner;
+      hi[comp0] = coord0 + inner;
+      lo[comp1] = from1;
+      hi[comp1] = to1;
+      int area = graph.add_area(lo[0], lo[1], hi[0], hi[1]);
+      tunnel_area[i][comp0] = area;
+
+      int door[2];
+      door[comp0] = coord0;
+      door[comp1] = from1;
+      graph.add_portal({door[0], door[1]}, room_area[i], area);
+      door[comp1] = to1;
+      graph.add_portal({door[0], door[1]}, room_area[dst], area);
+    }
+  }
+  /* Crossings, each is listed by both tunnels. */
+  for (int i = 0; i < plan.n; i++) {
+    for (int j : plan.nodes[i].edges[0][1].intersections) {
+      graph.add_portal({plan.nodes[i].x, plan.nodes[j].y},
+                       tunnel_area[i][0], tunnel_area[j][1]);
+    }
+  }
+}
+
+/* What stands in a room of a generated map. */
+enum class Spawn { NONE, EXIT, ORC, BAT, ITEM };
+
+/* Chunks a generated map puts its walls and objects in. The walls are
+ * counted by the same builders as the map, so the arena of the map can
+ * take the chunks in its first block.
+ */
+struct ChunkCount {
+  explicit ChunkCount(std::pmr::memory_resource *scratch)
+      : terrain(scratch), occupancy(scratch), crowd(scratch) {}
+
+  void set_terrain(int x, int y, IGameState::Terrain) {
+    terrain.insert(chunk_key(x, y));
+  }
+
+  void spawn(Spawn spawn, int x, int y) {
+    occupancy.insert(chunk_key(x, y));
+    if (spawn == Spawn::ORC || spawn == Spawn::BAT)
+      crowd.insert(chunk_key(x, y));
+  }
+
+  size_t bytes() const {
+    return terrain.size() * sizeof(Grid<IGameState::Terrain>::Chunk) +
+           (occupancy.size() + crowd.size()) * sizeof(Grid<uint16_t>::Chunk);
+  }
+
+  std::pmr::unordered_set<uint64_t, ChunkKeyHash> terrain, occupancy, crowd;
+};
+
+std::unique_ptr<Map> gen_map(int n, uint64_t seed) {
+  Xoshiro256 gen{seed};
+  /* The plan and other scratch go in blocks freed at once. */
+  std::pmr::monotonic_buffer_resource scratch;
+  auto plan = gen_plan(n, gen, &scratch);
   const int min_tunnel_length = 3;
   const int box_width = 5;
   const int tunnel_width = 2;
@@ -371,43 +590,62 @@ std::unique_ptr<Map> gen_map(int n) {
     node.x = (node.x - x_offset) * factor + fixed_offset;
     node.y = (node.y - y_offset) * factor + fixed_offset;
   }
-  auto mp = std::make_unique<Map>();
+
+  /* Spawns are drawn first, so their chunks are counted with the walls. */
+  std::pmr::vector<Spawn> spawns(n, Spawn::NONE, &scratch);
+  for (int i = 0; i < n; i++) {
+    if (&plan.nodes[i] == start_node) {
+      spawns[i] = Spawn::EXIT;
+      continue;
+    }
+    switch (gen_int(gen, 0, 2)) {
+      case 0:
+        break;
+      case 1:
+        spawns[i] = gen_int(gen, 0, 1) == 0 ? Spawn::ORC : Spawn::BAT;
+        break;
+      case 2:
+        spawns[i] = Spawn::ITEM;
+        break;
+    }
+  }
+
+  ChunkCount count(&scratch);
+  for (int i = 0; i < n; i++) {
+    build_box_from_node(count, &plan.nodes[i], box_width, tunnel_width);
+    build_tunnels_from_node(count, plan, i, box_width, tunnel_width);
+    if (spawns[i] != Spawn::NONE)
+      count.spawn(spawns[i], plan.nodes[i].x, plan.nodes[i].y);
+  }
+  auto mp = std::make_unique<Map>(count.bytes());
   for (int i = 0; i < n; i++) {
     build_box_from_node(*mp, &plan.nodes[i], box_width, tunnel_width);
     build_tunnels_from_node(*mp, plan, i, box_width, tunnel_width);
   }
-  mp->push_exit(std::move(
-    std::make_unique<Exit>(start_node->x, start_node->y)));
-
-  //spawn mobs
-  std::random_device rd;
-  std::mt19937 gen(rd());
-  std::vector<int> p(3, 1);
-  std::discrete_distribution<> d(p.begin(), p.end());
-  for (auto &node : plan.nodes) {
-    if (&node == start_node)
-      continue;
+  build_room_graph(*mp, plan, box_width, tunnel_width);
+  mp->push_exit(mp->arena.make<Exit>(start_node->x, start_node->y));
 
-    switch (d(gen)) {
-      case 0:
+  for (int i = 0; i < n; i++) {
+    auto &node = plan.nodes[i];
+    switch (spawns[i]) {
+      case Spawn::NONE:
+      case Spawn::EXIT:
         break;
-      case 1: {
-        if ((unsigned long) gen() % 2 == 0)
-          mp->push_new_object(mp->mobs, std::move(std::unique_ptr<Mob>(
-            std::move(std::make_unique<Orc>(node.x, node.y)))));
-        else
-          mp->push_new_object(mp->mobs, std::move(std::unique_ptr<Mob>(
-            std::move(std::make_unique<Bat>(node.x, node.y)))));
+      case Spawn::ORC:
+        mp->push_new_object(mp->mobs, ArenaPtr<Mob>(
+          mp->arena.make<Orc>(node.x, node.y)));
         break;
-      } case 2: {
-        auto item = std::unique_ptr<GameState::Item>(
-          std::move(std::make_unique<Stick>()));
-        mp->push_new_object(mp->items, std::move(std::make_unique<ItemObject>(
-          std::move(item), node.x, node.y)));
+      case Spawn::BAT:
+        mp->push_new_object(mp->mobs, ArenaPtr<Mob>(
+          mp->arena.make<Bat>(node.x, node.y)));
+        break;
+      case Spawn::ITEM:
+        mp->push_new_object(mp->items, mp->arena.make<ItemObject>(
+          IGameState::ItemDescriptor::STICK, node.x, node.y));
         break;
-      }
     }
   }
+  mp->seed(seed);
   return mp;
 }
 
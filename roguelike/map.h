@@ -1,21 +1,60 @@
 #pragma once
 #include <algorithm>
+#include <cstdint>
+#include <cstdlib>
 #include <filesystem>
+#include <memory_resource>
 #include <utility>
 #include <vector>
-#include <set>
+#include <type_traits>
 
+#include "activity.h"
+#include "arena.h"
+#include "entity_store.h"
+#include "fov.h"
+#include "grid.h"
 #include "objects.h"
 #include "panic.h"
+#include "pathfinder.h"
+#include "room_graph.h"
+#include "spatial_hash.h"
 #include "state.h"
 
+/* The plan is scratch of `gen_map`, its vectors share one resource. */
 struct edge {
-    int dst;
-    std::vector<int> intersections;
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    edge() = default;
+    explicit edge(const allocator_type& alloc) : intersections(alloc) {}
+    edge(const edge& other, const allocator_type& alloc)
+      : dst(other.dst), intersections(other.intersections, alloc) {}
+    edge(edge&& other, const allocator_type& alloc)
+      : dst(other.dst), intersections(std::move(other.intersections), alloc) {}
+    edge(const edge&) = default;
+    edge(edge&&) = default;
+    edge& operator=(const edge&) = default;
+    edge& operator=(edge&&) = default;
+
+    int dst = 0;
+    std::pmr::vector<int> intersections;
 };
 
 struct plan_node {
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
     plan_node() = default;
+    explicit plan_node(const allocator_type& alloc)
+      : edges{{edge(alloc), edge(alloc)}, {edge(alloc), edge(alloc)}} {}
+    plan_node(const plan_node& other, const allocator_type& alloc)
+      : x(other.x), y(other.y),
+        edges{{edge(other.edges[0][0], alloc), edge(other.edges[0][1], alloc)},
+              {edge(other.edges[1][0], alloc), edge(other.edges[1][1], alloc)}} {}
+    plan_node(plan_node&& other, const allocator_type& alloc)
+      : plan_node(other, alloc) {}
+    plan_node(const plan_node&) = default;
+    plan_node(plan_node&&) = default;
+    plan_node& operator=(const plan_node&) = default;
+    plan_node& operator=(plan_node&&) = default;
 
     plan_node(int x, int y) : x(x), y(y) {
       edges[0][0].dst = edges[0][1].dst =
@@ -26,76 +65,288 @@ struct plan_node {
 };
 
 struct plan {
-    plan(int n, std::vector<plan_node> nodes) : n(n), nodes(std::move(nodes)) {}
+    plan(int n, std::pmr::vector<plan_node> nodes)
+      : n(n), nodes(std::move(nodes)) {}
 
     int n;
-    std::vector<plan_node> nodes;
+    std::pmr::vector<plan_node> nodes;
 };
 
 struct Map {
+  /* Objects are built in the arena of their map. */
+  template <typename T>
+  using Objects = std::pmr::vector<ArenaPtr<T>>;
+
   friend class GameState;
   friend class Player;
   friend class Mob;
+  friend class DecisionTreeMob;
   friend class ItemObject;
+  friend class GameStateObject;
 
   /* Each map contains player. */
   Map(IGameState::Object* player);
   Map();
+  /* The arena takes `arena_size` bytes from the system at first. */
+  explicit Map(size_t arena_size);
   Map(const std::filesystem::path& path);
   friend class World;
 
   bool has_object(int x, int y, const IGameState::Object* exclude) const;
-  std::set<std::pair<int, int>> get_obstacles() const;
 
+  /* Whether a mob can not step to (x, y) whatever other mobs do: there
+   * is terrain, the player or an object other than a mob. Tiles of mobs
+   * are left to `ReservationTable::resolve`, their mobs may go away.
+   */
+  bool is_blocked(int x, int y) const;
+
+  /* Count of memory blocks the map requested from the system. */
+  size_t system_allocations() const { return arena.system_allocations(); }
+
+  /* Moves an object of the map, keeping occupancy up to date. The
+   * columns hold the position, the object reads it from there.
+   */
   template <typename T>
-  bool remove_object(std::vector<std::unique_ptr<T>> &container, T *item) {
-    auto container_it = std::find_if(container.begin(), container.end(),
-      [&](const std::unique_ptr<T> &ptr) { return ptr.get() == item; });
-
-    if (container_it != container.end()) {
-      container.erase(container_it);
-      auto as_obj = static_cast<IGameState::Object*>(item);
-      auto it = std::find(objects.begin(), objects.end(), as_obj);
-      if (it == objects.end()) {
-        panic("there must be object");
+  void move_object(T* obj, int x, int y) {
+    auto as_obj = static_cast<IGameState::Object*>(obj);
+    leave(as_obj);
+    auto i = entities.index(obj->entity);
+    if constexpr (is_mob<T>) {
+      --crowd.at(entities.xs[i], entities.ys[i]);
+      ++crowd.at(x, y);
+    }
+    spatial.move(obj->entity, entities.xs[i], entities.ys[i], x, y);
+    entities.xs[i] = x;
+    entities.ys[i] = y;
+    occupy(as_obj);
+  }
+
+  // Calls `f(handle, object)` for each object of the map with x in
+  // [lx, ux) and y in [ly, uy). The player is not included. Cost is
+  // proportional to the count of objects around the area.
+  template <typename F>
+  void query_rect(int lx, int ly, int ux, int uy, F&& f) const {
+    spatial.for_each_candidate(lx, ly, ux, uy, [&](EntityStore::Handle h) {
+      auto i = entities.index(h);
+      int x = entities.xs[i], y = entities.ys[i];
+      if (lx <= x && x < ux && ly <= y && y < uy) {
+        f(h, entities.objects[i]);
       }
-      objects.erase(it);
-      return true;
+    });
+  }
+
+  /* Same for objects within Manhattan distance `r` of (x, y). */
+  template <typename F>
+  void query_radius(int x, int y, int r, F&& f) const {
+    query_rect(x - r, y - r, x + r + 1, y + r + 1,
+               [&](EntityStore::Handle h, IGameState::Object* obj) {
+                 auto [ox, oy] = obj->get_pos();
+                 if (std::abs(ox - x) + std::abs(oy - y) <= r) {
+                   f(h, obj);
+                 }
+               });
+  }
+
+  /* Updates health of an object of the map. */
+  template <typename T>
+  void set_health(T* obj, int health) {
+    entities.health[entities.index(obj->entity)] = health;
+  }
+
+  IGameState::Terrain get_terrain(int x, int y) const;
+
+  /* Tiles of static terrain and chests. The view is valid until
+   * the next terrain tile or chest is added or removed.
+   */
+  BitGridView get_obstacles() const;
+
+  // Shortest path around static obstacles, both ends included. On
+  // generated maps the route goes over the room graph first and is
+  // refined along its legs, otherwise it is searched tile by tile.
+  // Fails if the target is further than `radius`.
+  bool find_path(int sx, int sy, int tx, int ty, int radius,
+                 std::vector<Pathfinder::Cell>& path) const;
+
+  /* Mobs do not see further than this. */
+  static constexpr int VIEW_RADIUS = 8;
+
+  /* Whether (x, y) is seen from (from_x, from_y), walls and chests
+   * block the sight. The view from the last point is cached, so all
+   * mobs looking at the player during a turn share one shadowcast.
+   */
+  bool can_see(int from_x, int from_y, int x, int y) const;
+
+  /* Rooms and tunnels, empty unless the map is generated. */
+  const RoomGraph& get_rooms() const { return rooms; }
+
+  /* Changes each time an obstacle is added or removed, so results
+   * computed over the obstacles can be cached against it.
+   */
+  uint64_t get_version() const { return version; }
+
+  /* Marks an object destroyed: it frees its tile at once, but stays
+   * in the containers until `compact`, so a turn may keep iterating
+   * them. Returns false if the object is already destroyed.
+   */
+  template <typename T>
+  bool destroy_object(T* obj) {
+    if (!entities.alive(obj->entity) || !entities.kill(obj->entity)) {
+      return false;
+    }
+    auto as_obj = static_cast<IGameState::Object*>(obj);
+    leave(as_obj);
+    auto [x, y] = as_obj->get_pos();
+    spatial.erase(obj->entity, x, y);
+    if constexpr (is_mob<T>) {
+      activity.forget(obj->entity, x, y);
+      --crowd.at(x, y);
     }
-    return false;
+    if constexpr (is_obstacle<T>) {
+      touch_obstacles();
+    }
+    return true;
   }
 
+  template <typename T>
+  bool is_destroyed(const T* obj) const {
+    return !entities.alive(obj->entity) || entities.is_dead(obj->entity);
+  }
+
+  /* Removes destroyed objects in one linear sweep, ends a turn. */
+  void compact();
+
+  /* Distances of the AI levels of detail of the map's mobs. */
+  void set_activity(const ActivityConfig& config) { activity.config = config; }
+
+  /* Coroutine frames of the map's mob behaviours, freed ones are
+   * reused.
+   */
+  std::pmr::memory_resource* behaviour_frames() { return arena.resource(); }
+
+  /* Count of mobs which are not dormant. */
+  size_t awake_mobs() const { return activity.awake_count(); }
+
+  /* Restarts random streams of the mobs, the i-th mob of the map
+   * gets stream i of `seed`.
+   */
+  void seed(uint64_t seed);
+
+  template <typename Canvas>
   friend void build_box_from_node(
-    Map &mp, plan_node *node, int box_width, int tunnel_width);
+    Canvas &mp, plan_node *node, int box_width, int tunnel_width);
+  template <typename Canvas>
   friend void build_tunnels_from_node(
-    Map &mp, const plan &plan, int node_idx, int box_width, int tunnel_width);
-  friend std::unique_ptr<Map> gen_map(int n);
+    Canvas &mp, const plan &plan, int node_idx, int box_width, int tunnel_width);
+  friend void build_room_graph(
+    Map &mp, const plan &plan, int box_width, int tunnel_width);
+  friend std::unique_ptr<Map> gen_map(int n, uint64_t seed);
   friend std::unique_ptr<World> gen_world(int n);
 
  private:
-  std::vector<std::unique_ptr<Enter>> enters;
-  std::vector<std::unique_ptr<DungeonBlock>> dungeon_blocks;
-  std::vector<std::unique_ptr<Chest>> chests;
-  std::vector<std::unique_ptr<Wall>> walls;
-  std::vector<std::unique_ptr<Border>> borders;
-  std::vector<std::unique_ptr<Mob>> mobs;
-  std::vector<std::unique_ptr<ItemObject>> items;
-
-  std::unique_ptr<Exit> exit = nullptr;
+  /* Must outlive all objects of the map. */
+  Arena arena;
+
+  Objects<Enter> enters{arena.resource()};
+  Objects<Chest> chests{arena.resource()};
+  Objects<Mob> mobs{arena.resource()};
+  Objects<ItemObject> items{arena.resource()};
+
+  ArenaPtr<Exit> exit = nullptr;
   std::string name;
 
-  /* All objects that map contains. */
-  std::vector<IGameState::Object*> objects;
+  /* All objects that map contains, except the player. */
+  EntityStore entities{arena.resource()};
+
+  /* The player is shared between maps, so it is not counted
+   * in the occupancy and checked separately.
+   */
+  IGameState::Object* player = nullptr;
+
+  /* Count of objects (except the player) per tile. */
+  Grid<uint16_t> occupancy{arena.resource()};
+  /* Count of mobs per tile, a part of the occupancy. */
+  Grid<uint16_t> crowd{arena.resource()};
+
+  /* Alive objects (except the player) by position, kept up to date
+   * by `push_new_object`, `move_object` and `destroy_object`.
+   */
+  SpatialHash spatial{arena.resource()};
+
+  /* Walls, dungeon blocks and borders, one byte per tile. */
+  Grid<IGameState::Terrain> terrain{arena.resource()};
+
+  RoomGraph rooms{arena.resource()};
+
+  /* Which mobs think during a turn, see `DecisionTreeMob::tick`. */
+  Activity activity{arena.resource()};
+
+  void set_terrain(int x, int y, IGameState::Terrain tile);
+
+  void occupy(const IGameState::Object* obj);
+  void leave(const IGameState::Object* obj);
+
+  /* Static terrain never moves, the bitmap is rebuilt lazily
+   * only when some obstacle is added or removed.
+   */
+  template <typename T>
+  static constexpr bool is_obstacle = std::is_base_of_v<Chest, T>;
 
+  /* Mobs are also kept in the crowd and in the activity schedule,
+   * whichever type of mob a caller holds.
+   */
   template <typename T>
-  void push_new_object(std::vector<std::unique_ptr<T>>& container,
-                       std::unique_ptr<T> object) {
-    objects.push_back(object.get());
+  static constexpr bool is_mob = std::is_base_of_v<Mob, T>;
+
+  mutable BitGrid obstacles{arena.resource()};
+  mutable bool obstacles_dirty = true;
+
+  mutable FieldOfView view;
+  mutable uint64_t view_version = 0;
+  uint64_t version = 0;
+
+  void touch_obstacles() {
+    obstacles_dirty = true;
+    ++version;
+  }
+
+  void build_obstacles() const;
+
+  /* Drops objects whose entities were compacted away, keeps the order. */
+  template <typename T>
+  void sweep(Objects<T>& container) {
+    uint32_t j = 0;
+    for (uint32_t i = 0; i < container.size(); ++i) {
+      if (!entities.alive(container[i]->entity)) {
+        container[i].reset();
+        continue;
+      }
+      if (i != j) {
+        container[j] = std::move(container[i]);
+      }
+      ++j;
+    }
+    container.erase(container.begin() + j, container.end());
+  }
+
+  template <typename T>
+  void push_new_object(Objects<T>& container, ArenaPtr<T> object) {
+    object->owner = this;
+    object->entity = entities.push(object.get());
+    auto [x, y] = static_cast<IGameState::Object*>(object.get())->get_pos();
+    spatial.insert(object->entity, x, y);
+    if constexpr (is_mob<T>) {
+      activity.add(object->entity, x, y);
+      ++crowd.at(x, y);
+    }
+    occupy(object.get());
+    if constexpr (is_obstacle<T>) {
+      touch_obstacles();
+    }
     container.push_back(std::move(object));
   }
 
   void push_player(IGameState::Object* player);
-  void push_exit(std::unique_ptr<Exit> exit_obj);
+  void push_exit(ArenaPtr<Exit> exit_obj);
   std::tuple<int, int> start_pos() const;
 };
 
@@ -104,15 +355,18 @@ struct World {
 
   World() = default;
 
-  World(const std::filesystem::path& dir);
+  /* Maps of the world draw random numbers from streams of `seed`. */
+  World(const std::filesystem::path& dir, uint64_t seed = 0);
 
   //friend std::unique_ptr<World> gen_world(int n);
 
   private:
     const std::filesystem::path dir;
+    const uint64_t seed;
     std::vector<std::unique_ptr<Map>> maps;
     std::unique_ptr<Player> player;
     Map* start_map;
 };
 
-std::unique_ptr<Map> gen_map(int n);
\ No newline at end of file
+// Generates a map of `n` rooms, the same for the same seed.
+std::unique_ptr<Map> gen_map(int n, uint64_t seed);
\ No newline at end of file
@@ -1,11 +1,14 @@
 #include "objects.h"
 
 #include <algorithm>
-#include <deque>
-#include <set>
 #include <string_view>
+#include <tuple>
+#include <vector>
 
+#include "flood_fill.h"
 #include "map.h"
+#include "reservation.h"
+#include "worker_pool.h"
 
 int get_exp_by_lvl(int lvl) {
   int p = 15;
@@ -56,36 +59,15 @@ void Player::move(const IGameState::PlayerMoveEvent& event) {
   }
 }
 
-std::set<std::pair<int, int>> bfs_get_attack_area(Map* map, int x, int y,
-                                                  int d) {
-  const int dx[] = {0, 0, 1, -1};
-  const int dy[] = {-1, 1, 0, 0};
-
-  std::set<std::pair<int, int>> vis;
-  std::deque<std::pair<int, int>> q;
-  q.push_back({x, y});
-  vis.insert({x, y});
-  auto obstacles = map->get_obstacles();
-  while (!q.empty()) {
-    auto [nx, ny] = q.front();
-    q.pop_front();
-    for (size_t i = 0; i < sizeof(dx) / sizeof(int); ++i) {
-      auto xx = nx + dx[i];
-      auto yy = ny + dy[i];
-      if (obstacles.find({xx, yy}) == obstacles.end() &&
-          vis.find({xx, yy}) == vis.end() && abs(xx - x) + abs(yy - y) <= d) {
-        vis.insert({xx, yy});
-        q.push_back({xx, yy});
-      }
-    }
-  }
-
-  return vis;
+void bfs_get_attack_area(Map* map, int x, int y, int d, Region& area) {
+  /* Scratch rows are reused by all attack area requests. */
+  thread_local BitFlood flood;
+  flood.run(map->get_obstacles(), x, y, d, area);
 }
 
-std::set<std::pair<int, int>> Player::get_attack_area() const {
+void Player::get_attack_area(Region& area) const {
   const int d = hand ? hand->radius : 0;
-  return bfs_get_attack_area(state->get_current_map(), x, y, d);
+  bfs_get_attack_area(state->get_current_map(), x, y, d, area);
 }
 
 int Player::get_lvl() const { return lvl.get_lvl(); }
@@ -126,22 +108,35 @@ Mob::Mob(int x, int y, int health, int max_health, int attack_radius, int dmg,
 
 IGameState::ObjectDescriptor Mob::get_descriptor() const { return descriptor; }
 
-std::tuple<int, int> Mob::get_health() const { return {health, max_health}; }
+std::tuple<int, int> Mob::get_pos() const {
+  return column_pos(*this);
+}
+
+std::tuple<int, int> Mob::get_health() const {
+  auto i = column();
+  return {i == NOT_PLACED ? health : owner->entities.health[i], max_health};
+}
 
 int Mob::get_damage() const { return dmg; }
 
 void Mob::damage(int x) {
-  health = std::max(health - x, 0);
-  if (health == 0) {
-    auto map = state->get_current_map();
+  if (owner->is_destroyed(this)) {
+    return;
+  }
+  int left = std::max(std::get<0>(get_health()) - x, 0);
+  owner->set_health(this, left);
+  if (left == 0) {
     /* Add exp. */
     dynamic_cast<Player*>(state->get_player())->add_exp(exp);
-    map->remove_object(map->mobs, this);
+    owner->destroy_object(this);
   }
 }
 
-std::set<std::pair<int, int>> Mob::get_attack_area() const {
-    return bfs_get_attack_area(state->get_current_map(), x, y, attack_radius);
+void Mob::set_pos(int xx, int yy) { owner->move_object(this, xx, yy); }
+
+void Mob::get_attack_area(Region& area) const {
+  auto [x, y] = get_pos();
+  bfs_get_attack_area(state->get_current_map(), x, y, attack_radius, area);
 }
 
 void Mob::apply() {
@@ -156,35 +151,25 @@ void Mob::apply() {
   }
 }
 
-/* Wall impl. */
-Wall::Wall(int x, int y) : IGameState::Object{x, y} {}
-Wall::Wall(int x, int y, std::string_view label)
-    : IGameState::Object{x, y}, label(std::move(label)) {}
-IGameState::ObjectDescriptor Wall::get_descriptor() const {
-  return IGameState::ObjectDescriptor::WALL;
-}
-std::optional<std::string_view> Wall::get_label() const { return label; }
-
 /* Chest impl. */
 Chest::Chest(int x, int y) : IGameState::Object{x, y} {}
-IGameState::ObjectDescriptor Chest::get_descriptor() const {
-  return IGameState::ObjectDescriptor::CHEST;
-}
 
-/* DungeonBlock impl. */
-DungeonBlock::DungeonBlock(int x, int y, std::string_view label)
-    : IGameState::Object{x, y}, label(label) {}
-IGameState::ObjectDescriptor DungeonBlock::get_descriptor() const {
-  return IGameState::ObjectDescriptor::STONE;
+std::tuple<int, int> Chest::get_pos() const {
+  return column_pos(*this);
 }
-std::optional<std::string_view> DungeonBlock::get_label() const {
-  return label;
+
+IGameState::ObjectDescriptor Chest::get_descriptor() const {
+  return IGameState::ObjectDescriptor::CHEST;
 }
 
 /* Enter impl. */
 Enter::Enter(int x, int y, std::string_view label, std::string transition)
     : IGameState::IEnter{x, y, std::move(transition)}, label(label), map(nullptr) {}
 
+std::tuple<int, int> Enter::get_pos() const {
+  return column_pos(*this);
+}
+
 IGameState::ObjectDescriptor Enter ::get_descriptor() const {
   return IGameState::ObjectDescriptor::ENTER;
 }
@@ -199,22 +184,24 @@ const Map* Enter::get_map() const { return map; }
 
 void Enter::apply() {
   auto [xp, yp] = state->get_player()->get_pos();
-  if (map != nullptr && abs(xp - x) + abs(yp - y) <= 1) {
+  auto [x, y] = get_pos();
+  if (abs(xp - x) + abs(yp - y) > 1) {
+    return;
+  }
+  /* The job generating the map may not have run yet. */
+  state->generate_map(this);
+  if (map != nullptr) {
     state->move_on(map);
   }
 }
 
-/* Border impl. */
-Border::Border(int x, int y, IGameState::ObjectDescriptor descriptor)
-    : IGameState::Object{x, y}, descriptor{descriptor} {}
-
-IGameState::ObjectDescriptor Border::get_descriptor() const {
-  return descriptor;
-}
-
 /* Exit impl. */
 Exit::Exit(int x, int y) : IGameState::Object{x, y} {}
 
+std::tuple<int, int> Exit::get_pos() const {
+  return column_pos(*this);
+}
+
 IGameState::ObjectDescriptor Exit::get_descriptor() const {
   return IGameState::ObjectDescriptor::EXIT;
 }
@@ -222,6 +209,7 @@ IGameState::ObjectDescriptor Exit::get_descriptor() const {
 void Exit::apply() {
   assert(state != nullptr);
   auto [xp, yp] = state->get_player()->get_pos();
+  auto [x, y] = get_pos();
   if (abs(xp - x) + abs(yp - y) <= 1) {
     state->move_back();
   }
@@ -230,6 +218,11 @@ void Exit::apply() {
 const int ORC_DAMAGE_RADIUS = 3;
 const int ORC_VIEW_FIELD = 6;
 const int ORC_DMG = 2;
+const int ORC_PURSUIT_TURNS = 20;
+/* Orc loses the player further than this. */
+const int ORC_PURSUIT_RADIUS = 48;
+/* Orcs act once per turn. */
+const int ORC_DELAY = TURN_TIME;
 
 struct DistanceComparatorLess {
   bool operator()(const std::pair<int, int>& lhs,
@@ -252,17 +245,15 @@ struct DistanceComparatorGreater {
 };
 
 bool OrcDecideAttack::operator()(Orc& orc) {
-  auto [x, y] = orc.get_pos();
-  auto player = dynamic_cast<Player*>(orc.state->get_player());
-  auto [px, py] = player->get_pos();
-  int dist = abs(x - px) + abs(y - py);
+  int dist = orc.get_blackboard().distance;
   if (dist < ORC_DAMAGE_RADIUS) {
     /* Attack always when player is too close
      * to could attack on next step.
      */
     return true;
   }
-  if (dist == ORC_DAMAGE_RADIUS && rand() % 3 == 0) {
+  if (dist == ORC_DAMAGE_RADIUS &&
+      uniform_below(orc.get_blackboard().random, 3) == 0) {
     /*
      * Orc can strike despite the fact that he will not
      * catch up with the enemy further with
@@ -275,120 +266,367 @@ bool OrcDecideAttack::operator()(Orc& orc) {
 
 bool OrcDecideCloser::operator()(Orc& orc) {
   auto [x, y] = orc.get_pos();
-  auto player = dynamic_cast<Player*>(orc.state->get_player());
-  auto [px, py] = player->get_pos();
-  int dist = abs(x - px) + abs(y - py);
-  return dist <= ORC_VIEW_FIELD;
+  auto [px, py] = orc.state->get_player()->get_pos();
+  if (orc.get_blackboard().distance <= ORC_VIEW_FIELD &&
+      orc.state->get_current_map()->can_see(px, py, x, y)) {
+    /* Pursuit lasts for a while after the player is out of sight. */
+    orc.get_blackboard().timer = ORC_PURSUIT_TURNS;
+    return true;
+  }
+  return false;
+}
+
+bool OrcDecidePursue::operator()(Orc& orc) {
+  auto& pursuit = orc.get_blackboard().timer;
+  if (pursuit == 0) {
+    return false;
+  }
+  --pursuit;
+  return true;
 }
 
 /* Orc impl. */
+/* Idle orcs keep this close to their spawn. */
+const int ORC_WANDER_RADIUS = 4;
+/* Orcs go back to the spawn from this far at most. */
+const int ORC_HOME_RADIUS = 64;
+/* Turns an orc waits on its way home before it gives up. */
+const int ORC_PATIENCE = 3;
+
+// Orc wanders around its spawn until it sees the player. Then it
+// strikes when close, runs at the player while it is seen and then
+// goes along a path to where it saw the player last, for a while.
+// Then it goes back to the spawn.
+#pragma GCC diagnostic push
+/* The frame header names its resource, so the sized delete matches. */
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+Behaviour orc_behaviour(std::allocator_arg_t, std::pmr::memory_resource*,
+                        Orc& orc) {
+  auto [sx, sy] = orc.get_pos();
+  auto from_spawn = [&] {
+    auto [x, y] = orc.get_pos();
+    return std::abs(x - sx) + std::abs(y - sy);
+  };
+  /* The cell where the orc saw the player last. */
+  auto [lx, ly] = orc.get_pos();
+  auto sees = [&] {
+    if (!OrcDecideCloser{}(orc)) {
+      return false;
+    }
+    std::tie(lx, ly) = orc.get_state()->get_player()->get_pos();
+    return true;
+  };
+  while (true) {
+    std::tie(lx, ly) = orc.get_pos();
+    while (orc.get_blackboard().distance > ORC_DAMAGE_RADIUS && !sees()) {
+      random_walk_near(orc, sx, sy, ORC_WANDER_RADIUS);
+      co_await next_step();
+    }
+
+    bool acted = false;
+    while (true) {
+      /* Looks first, so that an attack also marks where the player is. */
+      bool seen = sees();
+      if (OrcDecideAttack{}(orc)) {
+        attack(orc);
+      } else if (seen) {
+        keep_distance<Orc, DistanceComparatorLess>(orc);
+      } else if (OrcDecidePursue{}(orc)) {
+        follow_path_to(orc, lx, ly, ORC_PURSUIT_RADIUS);
+      } else {
+        break;
+      }
+      acted = true;
+      co_await next_step();
+    }
+    if (!acted) {
+      /* Close but unseen and the strike missed its chance, the step
+       * goes on wandering rather than rolling again.
+       */
+      random_walk_near(orc, sx, sy, ORC_WANDER_RADIUS);
+      co_await next_step();
+    }
+
+    int blocked = 0;
+    while (from_spawn() > ORC_WANDER_RADIUS && !sees()) {
+      bool found = follow_path_to(orc, sx, sy, ORC_HOME_RADIUS);
+      blocked = orc.intent().kind == Intent::Kind::STAY
+                    ? blocked + 1
+                    : 0;
+      if (!found || blocked > ORC_PATIENCE) {
+        /* Lost or the way is taken, settles where it is. */
+        std::tie(sx, sy) = orc.get_pos();
+        break;
+      }
+      co_await next_step();
+    }
+  }
+}
+#pragma GCC diagnostic pop
+
 Orc::Orc(int x, int y)
-    : DecisionTreeMob{
-          x,
-          y,
-          15,
-          ORC_DMG,
-          4,
-          ORC_DAMAGE_RADIUS,
-          IGameState::ObjectDescriptor::ORC,
-          std::make_shared<ConditionNode<Orc>>(
-              *this,
-              /* Conditions. */
-              std::vector<ConditionNode<Orc>::Node>{
-                  {
-                      .predicate = [](Orc& orc) -> bool {
-                        return OrcDecideAttack{}(orc);
-                      },
-                      .next = std::make_shared<AttackNode<Orc>>(*this),
-                  },
-                  {
-                      .predicate = [](Orc& orc) -> bool {
-                        return OrcDecideCloser{}(orc);
-                      },
-                      .next = std::make_shared<
-                          DistanceComparatorNode<Orc, DistanceComparatorLess>>(
-                          *this),
-                  },
-              },
-              /* Default. */
-              std::make_shared<RandowWalkNode<Orc>>(x, y, 8, *this))} {}
+    : DecisionTreeMob{x,
+                      y,
+                      15,
+                      ORC_DMG,
+                      4,
+                      ORC_DAMAGE_RADIUS,
+                      ORC_DELAY,
+                      IGameState::ObjectDescriptor::ORC} {}
+
+void Orc::start(std::pmr::memory_resource* frames) {
+  if (!behaviour) {
+    behaviour = orc_behaviour(std::allocator_arg, frames, *this);
+  }
+}
+
+void Orc::think() {
+  intent() = Intent{};
+  behaviour.resume();
+}
+
+void Orc::move() {
+  observe();
+  start(owner->behaviour_frames());
+  think();
+  apply_intent();
+}
 
 /* Bat impl. */
 const int BAT_DMG = 0;
 const int BAT_EXP = 2;
+const int BAT_VIEW_FIELD = 5;
+/* Bats act three times per two turns. */
+const int BAT_DELAY = TURN_TIME * 2 / 3;
 
 bool BatDecideRun::operator()(Bat& bat) {
   auto [x, y] = bat.get_pos();
-  auto player = dynamic_cast<Player*>(bat.state->get_player());
-  auto [px, py] = player->get_pos();
-  int dist = abs(x - px) + abs(y - py);
-  return dist <= 5;
+  auto [px, py] = bat.state->get_player()->get_pos();
+  return bat.get_blackboard().distance <= BAT_VIEW_FIELD &&
+         bat.state->get_current_map()->can_see(px, py, x, y);
 }
 
 bool BatDecideSleep::operator()(Bat& bat) {
   /*
    * Bat can sleep with 25% probability.
    */
-  return rand() % 4 == 0;
+  return uniform_below(bat.get_blackboard().random, 4) == 0;
+}
+
+DecisionTable<Bat> make_bat_table() {
+  DecisionTable<Bat> table;
+  auto run = table.branch(
+      [](Bat& bat) -> bool { return BatDecideRun{}(bat); },
+      table.leaf(keep_distance<Bat, DistanceComparatorGreater>),
+      table.leaf(random_walk<Bat>));
+  table.root = table.branch(
+      [](Bat& bat) -> bool { return BatDecideSleep{}(bat); },
+      table.leaf(no_op<Bat>), run);
+  return table;
 }
 
+const DecisionTable<Bat> BAT_TABLE = make_bat_table();
+
 Bat::Bat(int x, int y)
-    : DecisionTreeMob{
-          x,
-          y,
-          7,
-          0,
-          BAT_EXP,
-          0,
-          IGameState::ObjectDescriptor::BAT,
-          std::make_shared<ConditionNode<Bat>>(
-              *this,
-              std::vector<ConditionNode<Bat>::Node>{
-                  {
-                      .predicate = [](Bat& bat) -> bool {
-                        return BatDecideSleep{}(bat);
-                      },
-                      .next = std::make_shared<NoOpNode>(),
-                  },
-                  {
-                      .predicate = [](Bat& bat) -> bool {
-                        return BatDecideRun{}(bat);
-                      },
-                      .next = std::make_shared<DistanceComparatorNode<
-                          Bat, DistanceComparatorGreater>>(*this),
-                  },
-              },
-              /* Default. */
-              std::make_shared<RandowWalkNode<Bat>>(x, y, 8, *this))} {}
+    : DecisionTreeMob{x,
+                      y,
+                      7,
+                      BAT_DMG,
+                      BAT_EXP,
+                      0,
+                      BAT_DELAY,
+                      IGameState::ObjectDescriptor::BAT} {}
+
+void Bat::move() {
+  observe();
+  BAT_TABLE.run(*this);
+  apply_intent();
+}
 
 /* DecisionTreeMob impl. */
 DecisionTreeMob::DecisionTreeMob(int x, int y, int max_health, int dmg, int exp,
-                                 int attack_radius,
-                                 IGameState::ObjectDescriptor descriptor,
-                                 std::shared_ptr<DecisionTreeNode> root)
+                                 int attack_radius, int delay,
+                                 IGameState::ObjectDescriptor descriptor)
     : Mob{x, y, max_health, max_health, attack_radius, dmg, exp, descriptor},
-      root{root} {}
+      delay{delay} {
+  /* Mobs start on distinct tiles, so their streams differ until
+   * the map seeds them.
+   */
+  seed(stream_seed(0, (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+                          static_cast<uint32_t>(y)));
+}
+
+void DecisionTreeMob::seed(uint64_t seed) { board.random = SplitMix64{seed}; }
 
-void DecisionTreeMob::move() { interpretate(root); }
+Blackboard& DecisionTreeMob::get_blackboard() { return board; }
+
+int DecisionTreeMob::get_delay() const { return delay; }
+
+Intent& DecisionTreeMob::intent() { return owner->entities.intents[column()]; }
+
+void DecisionTreeMob::observe() {
+  auto [x, y] = get_pos();
+  auto [px, py] = state->get_player()->get_pos();
+  board.distance = std::abs(x - px) + std::abs(y - py);
+}
+
+void DecisionTreeMob::apply_intent() {
+  const auto& intent = this->intent();
+  switch (intent.kind) {
+    case Intent::Kind::MOVE:
+      if (!owner->has_object(intent.x, intent.y, this)) {
+        set_pos(intent.x, intent.y);
+      }
+      break;
+    case Intent::Kind::ATTACK:
+      state->damage_player(intent.damage);
+      break;
+    case Intent::Kind::STAY:
+      break;
+  }
+}
+
+/* Chooses intents of the picked mobs of one type in [begin, end)
+ * with `think`, coarse ones just wander.
+ */
+template <typename T, typename F>
+void decide_all(const EntityStore& entities,
+                const std::vector<Activity::Pick>& picks, size_t begin,
+                size_t end, IGameState::ObjectDescriptor descriptor, int px,
+                int py, F&& think) {
+  for (size_t k = begin; k < end; ++k) {
+    auto i = picks[k].index;
+    if (entities.descriptors[i] != descriptor) {
+      continue;
+    }
+    auto mob = static_cast<T*>(entities.objects[i]);
+    if (picks[k].coarse) {
+      random_walk(*mob);
+      continue;
+    }
+    mob->get_blackboard().distance =
+        std::abs(entities.xs[i] - px) + std::abs(entities.ys[i] - py);
+    think(*mob);
+  }
+}
+
+size_t DecisionTreeMob::tick(Map& map, int px, int py, WorkerPool& pool,
+                             ActionBudget budget) {
+  thread_local std::vector<Activity::Pick> picks;
+  thread_local ReservationTable reservations;
+  thread_local std::vector<ReservationTable::Move> moves;
+  thread_local std::vector<DecisionTreeMob*> movers;
+
+  const auto& entities = map.entities;
+  auto& activity = map.activity;
+  activity.begin_turn(entities, px, py);
+
+  /* Lazy caches of the map are filled now, so the intent phase
+   * only reads the map.
+   */
+  map.can_see(px, py, px, py);
+
+  /* Mobs due at the same game time act together in a round, faster
+   * mobs may have several rounds in a turn.
+   */
+  size_t deferred = 0;
+  while (activity.next_round(entities, map.rooms, px, py, picks)) {
+    /* Mobs around the player act whatever it takes, coarse ones while
+     * the budget lasts.
+     */
+    if (budget.remaining() < picks.size()) {
+      deferred += activity.defer_coarse(entities, picks, budget.remaining());
+      if (picks.empty()) {
+        continue;
+      }
+    }
+    budget.spend(picks.size());
+    for (auto pick : picks) {
+      /* Frames are allocated here, workers only resume them. */
+      auto i = pick.index;
+      if (entities.descriptors[i] == IGameState::ObjectDescriptor::ORC) {
+        static_cast<Orc*>(entities.objects[i])->start(map.behaviour_frames());
+      }
+    }
+    /* Intents depend on the map at the start of the round and on
+     * the mob itself only, any split between threads gives the same.
+     * `picks` is thread_local, so it is captured by name: a worker
+     * naming it would get its own, empty one.
+     */
+    pool.run(picks.size(), TICK_GRAIN,
+             [&, &picks = picks](size_t begin, size_t end) {
+      decide_all<Orc>(entities, picks, begin, end,
+                      IGameState::ObjectDescriptor::ORC, px, py,
+                      [](Orc& orc) { orc.think(); });
+      decide_all<Bat>(entities, picks, begin, end,
+                      IGameState::ObjectDescriptor::BAT, px, py,
+                      [](Bat& bat) { BAT_TABLE.run(bat); });
+    });
+
+    /* Targets of moves were free or held by mobs at the start of the
+     * round. Moves are settled together, so mobs in a crowd follow and
+     * swap with each other; ties go to the earliest mob of the map.
+     */
+    moves.clear();
+    movers.clear();
+    for (auto pick : picks) {
+      auto i = pick.index;
+      auto mob = static_cast<DecisionTreeMob*>(entities.objects[i]);
+      const auto& intent = entities.intents[i];
+      switch (intent.kind) {
+        case Intent::Kind::MOVE:
+          if (intent.x != entities.xs[i] || intent.y != entities.ys[i]) {
+            moves.push_back(ReservationTable::Move{
+                entities.xs[i], entities.ys[i], intent.x, intent.y});
+            movers.push_back(mob);
+          }
+          break;
+        case Intent::Kind::ATTACK:
+          mob->state->damage_player(intent.damage);
+          break;
+        case Intent::Kind::STAY:
+          break;
+      }
+      activity.schedule(entities.handles[i], mob->delay, pick.coarse);
+    }
+    reservations.resolve(moves, [&](int x, int y) {
+      return map.has_object(x, y, nullptr);
+    });
+    for (size_t k = 0; k < moves.size(); ++k) {
+      if (reservations.moves(k)) {
+        movers[k]->set_pos(moves[k].to_x, moves[k].to_y);
+      }
+    }
+  }
+  return deferred;
+}
 
 /* Item impl. */
-ItemObject::ItemObject(std::unique_ptr<GameState::Item> item, int x, int y)
-  : item(std::move(item)), IGameState::Object{x, y} {}
+ItemObject::ItemObject(IGameState::ItemDescriptor item_descriptor, int x,
+                       int y)
+  : item_descriptor(item_descriptor), IGameState::Object{x, y} {}
+
+std::tuple<int, int> ItemObject::get_pos() const {
+  return column_pos(*this);
+}
 
 IGameState::ObjectDescriptor ItemObject::get_descriptor() const {
   return IGameState::ObjectDescriptor::ITEM;
 }
 
-const IGameState::Item *ItemObject::get_item() const {
-  return item.get();
+IGameState::ItemDescriptor ItemObject::get_item_descriptor() const {
+  return item_descriptor;
 }
 
 void ItemObject::apply() {
   auto player = dynamic_cast<Player *>(GameStateObject::state->get_player());
   auto [xp, yp] = player->get_pos();
+  auto [x, y] = get_pos();
   if (abs(xp - x) + abs(yp - y) <= 1) {
-    auto map = state->get_current_map();
+    if (item == nullptr) {
+      item = make_item(item_descriptor);
+    }
     if (player->put_item(item))
-      map->remove_object(map->items, this);
+      owner->destroy_object(this);
   }
 }
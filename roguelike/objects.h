@@ -1,8 +1,14 @@
 #pragma once
+#include <memory_resource>
+
+#include "behaviour.h"
 #include "decision_tree.h"
 #include "inventory.h"
 #include "items.h"
 #include "state.h"
+#include "turn_budget.h"
+
+struct WorkerPool;
 
 struct Level {
   Level();
@@ -30,11 +36,11 @@ struct Player : public GameStateObject, IGameState::IPlayer, Inventory {
 
   void move(const IGameState::PlayerMoveEvent& event);
 
-  std::set<std::pair<int, int>> get_attack_area() const override;
+  void get_attack_area(Region& area) const override;
 
   void heal(int hp);
 
-  void set_pos(int xx, int yy);
+  void set_pos(int xx, int yy) override;
 
   void damage(int hp);
 
@@ -68,7 +74,12 @@ struct Mob : public GameStateObject, IGameState::IMob {
 
   virtual void move() = 0;
 
-  std::set<std::pair<int, int>> get_attack_area() const override;
+  /* Position and health live in the columns of the map. */
+  std::tuple<int, int> get_pos() const override;
+
+  void set_pos(int xx, int yy) override;
+
+  void get_attack_area(Region& area) const override;
 
   std::tuple<int, int> get_health() const override;
 
@@ -79,6 +90,7 @@ struct Mob : public GameStateObject, IGameState::IMob {
 
  private:
   IGameState::ObjectDescriptor descriptor;
+  /* Health until the mob is placed, then the column has it. */
   int health;
   int max_health;
   int attack_radius;
@@ -86,34 +98,13 @@ struct Mob : public GameStateObject, IGameState::IMob {
   int exp;
 };
 
-struct Wall : public GameStateObject, IGameState::Object {
-  Wall(int x, int y);
-
-  Wall(int x, int y, std::string_view label);
-
-  IGameState::ObjectDescriptor get_descriptor() const override;
-
-  std::optional<std::string_view> get_label() const override;
-
-  std::optional<std::string_view> label;
-
-  friend class GameState;
-};
-
 struct Chest : public GameStateObject, IGameState::Object {
   Chest(int x, int y);
 
-  IGameState::ObjectDescriptor get_descriptor() const override;
-
-  friend class GameState;
-};
-
-struct DungeonBlock : public GameStateObject, IGameState::Object {
-  DungeonBlock(int x, int y, std::string_view label);
+  std::tuple<int, int> get_pos() const override;
 
   IGameState::ObjectDescriptor get_descriptor() const override;
-  std::optional<std::string_view> get_label() const override;
-  std::string_view label;
+
   friend class GameState;
 };
 
@@ -122,6 +113,8 @@ struct Enter : public GameStateObject, IGameState::IEnter {
 
   Enter(int x, int y, std::string_view label, std::string transition);
 
+  std::tuple<int, int> get_pos() const override;
+
   IGameState::ObjectDescriptor get_descriptor() const override;
 
   void set_map(Map* to_map);
@@ -140,52 +133,90 @@ struct Enter : public GameStateObject, IGameState::IEnter {
   Map* map;
 };
 
-struct Border : public GameStateObject, IGameState::Object {
-  friend class GameState;
-
-  Border(int x, int y, IGameState::ObjectDescriptor descriptor);
-
-  IGameState::ObjectDescriptor get_descriptor() const override;
-
-  IGameState::ObjectDescriptor descriptor;
-};
-
 struct Exit : public GameStateObject, IGameState::Object {
   friend class GameState;
 
   Exit(int x, int y);
 
+  std::tuple<int, int> get_pos() const override;
+
   IGameState::ObjectDescriptor get_descriptor() const override;
 
   void apply() override;
 };
 
-// DecisionTreeMob executes decision tree to decide
-// where to go.
+// DecisionTreeMob decides where to go with a decision table
+// shared by all mobs of its type, keeping own state in a blackboard.
 struct DecisionTreeMob : public Mob {
   friend class GameState;
 
+  /* The mob acts once per `delay` of game time, see `TURN_TIME`. */
   DecisionTreeMob(int x, int y, int max_health, int dmg, int exp,
-                  int attack_radius, IGameState::ObjectDescriptor descriptor,
-                  std::shared_ptr<DecisionTreeNode> root);
+                  int attack_radius, int delay,
+                  IGameState::ObjectDescriptor descriptor);
 
-  void move() override;
+  Blackboard& get_blackboard();
+
+  /* Game time between actions of the mob. */
+  int get_delay() const;
+
+  /* Restarts the random stream of the mob. */
+  void seed(uint64_t seed);
+
+  /* Intent of the mob for the round, kept in the columns of its map. */
+  Intent& intent();
+
+  // One turn of the mobs around the player, see `Activity` for which
+  // of them act and when. Mobs due at the same time act in a round:
+  // they choose their intents in parallel on the threads of `pool`,
+  // against the map as it was at the start of the round. Then the
+  // moves are settled together by `ReservationTable::resolve` and
+  // applied. The outcome does not depend on the count of threads.
+  // Coarse mobs over `budget` wait for the next turn and act after the
+  // mobs due in it. Returns the count of them.
+  static size_t tick(Map& map, int px, int py, WorkerPool& pool,
+                     ActionBudget budget = {});
+
+  /* Mobs per task of the intent phase, fewer run on one thread. */
+  static constexpr size_t TICK_GRAIN = 2048;
+
+ protected:
+  /* Looks at the player before a step of a single mob. */
+  void observe();
+
+  /* Applies the intent of a mob which steps alone. */
+  void apply_intent();
 
  private:
-  std::shared_ptr<DecisionTreeNode> root;
+  Blackboard board;
+  int delay;
 };
 
 struct OrcDecideAttack;
 struct OrcDecideCloser;
+struct OrcDecidePursue;
 
 // Stupid, just damages player.
-// Runs to player when see him.
+// Runs to player when see him, then pursues him for a while and goes
+// back home. Its behaviour is a coroutine, not a decision table.
 struct Orc : public DecisionTreeMob {
   friend class GameState;
   friend class OrcDecideAttack;
   friend class OrcDecideCloser;
+  friend class OrcDecidePursue;
 
   Orc(int x, int y);
+
+  void move() override;
+
+  /* Creates the behaviour with its frame in `frames`, once. */
+  void start(std::pmr::memory_resource* frames);
+
+  /* One step of the behaviour, chooses the intent. */
+  void think();
+
+ private:
+  Behaviour behaviour;
 };
 
 struct OrcDecideAttack {
@@ -196,6 +227,10 @@ struct OrcDecideCloser {
   bool operator()(Orc&);
 };
 
+struct OrcDecidePursue {
+  bool operator()(Orc&);
+};
+
 struct BatDecideRun;
 struct BatDecideSleep;
 
@@ -205,6 +240,8 @@ struct Bat : public DecisionTreeMob {
   friend class BatDecideSleep;
 
   Bat(int x, int y);
+
+  void move() override;
 };
 
 struct BatDecideRun {
@@ -218,12 +255,18 @@ struct BatDecideSleep {
 struct ItemObject : public GameStateObject, IGameState::Object {
   friend class GameState;
 
-  ItemObject(std::unique_ptr<GameState::Item> item, int x, int y);
+  /* The payload is made when the player takes the item, so items
+   * lying on a map take no memory outside of its arena.
+   */
+  ItemObject(IGameState::ItemDescriptor item_descriptor, int x, int y);
+
+  std::tuple<int, int> get_pos() const override;
 
   IGameState::ObjectDescriptor get_descriptor() const override;
 
-  const IGameState::Item *get_item() const;
+  IGameState::ItemDescriptor get_item_descriptor() const;
 
+  IGameState::ItemDescriptor item_descriptor;
   std::unique_ptr<GameState::Item> item;
 
   void apply() override;
@@ -0,0 +1,205 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include "grid.h"
+
+// A* with jump point search on a 4-connected grid of static obstacles.
+// Straight runs of free tiles are skipped by jumps, only their ends get
+// into the open list. The search is bounded by a square window around
+// the start, buffers are epoch-stamped and kept between searches.
+struct Pathfinder {
+  struct Cell {
+    int x, y;
+
+    bool operator==(const Cell& other) const {
+      return x == other.x && y == other.y;
+    }
+  };
+
+  // Finds a shortest path from (sx, sy) to (tx, ty) inside the window of
+  // `radius` around the start. On success `path` holds every tile of
+  // the path, both ends included.
+  bool find(BitGridView obstacles, int sx, int sy, int tx, int ty, int radius,
+            std::vector<Cell>& path) {
+    path.clear();
+    this->obstacles = &obstacles;
+    lx = sx - radius;
+    ly = sy - radius;
+    size = 2 * radius + 1;
+    this->tx = tx;
+    this->ty = ty;
+    if (!walkable(sx, sy) || !walkable(tx, ty)) {
+      return false;
+    }
+    prepare(static_cast<size_t>(size) * size);
+
+    open.clear();
+    push(index(sx, sy), -1, 0);
+    while (!open.empty()) {
+      std::pop_heap(open.begin(), open.end(), std::greater<>{});
+      auto [f, g, i] = open.back();
+      open.pop_back();
+      if (closed[i] == epoch || g != nodes[i].g) {
+        continue;
+      }
+      closed[i] = epoch;
+      int x = lx + i / size, y = ly + i % size;
+      if (x == tx && y == ty) {
+        build_path(i, path);
+        return true;
+      }
+      expand(i, x, y);
+    }
+    return false;
+  }
+
+ private:
+  struct Node {
+    int g;
+    int parent;
+  };
+
+  struct Open {
+    int f, g, index;
+
+    bool operator>(const Open& other) const {
+      /* Deeper nodes first among equal estimates. */
+      return f != other.f ? f > other.f : g < other.g;
+    }
+  };
+
+  bool walkable(int x, int y) const {
+    return lx <= x && x < lx + size && ly <= y && y < ly + size &&
+           !obstacles->test(x, y);
+  }
+
+  int index(int x, int y) const { return (x - lx) * size + (y - ly); }
+
+  void push(int i, int parent, int g) {
+    if (seen[i] == epoch && nodes[i].g <= g) {
+      return;
+    }
+    seen[i] = epoch;
+    nodes[i] = {g, parent};
+    int x = lx + i / size, y = ly + i % size;
+    int h = std::abs(x - tx) + std::abs(y - ty);
+    open.push_back({g + h, g, i});
+    std::push_heap(open.begin(), open.end(), std::greater<>{});
+  }
+
+  /* Jumps to successors along the directions which are not pruned. */
+  void expand(int i, int x, int y) {
+    int parent = nodes[i].parent;
+    auto try_jump = [&](int dx, int dy) {
+      int j = jump(x, y, dx, dy);
+      if (j != -1) {
+        int jx = lx + j / size, jy = ly + j % size;
+        push(j, i, nodes[i].g + std::abs(jx - x) + std::abs(jy - y));
+      }
+    };
+    if (parent == -1) {
+      try_jump(1, 0);
+      try_jump(-1, 0);
+      try_jump(0, 1);
+      try_jump(0, -1);
+      return;
+    }
+    int px = lx + parent / size, py = ly + parent % size;
+    int dx = (x > px) - (x < px);
+    int dy = (y > py) - (y < py);
+    if (dx != 0) {
+      try_jump(0, 1);
+      try_jump(0, -1);
+      try_jump(dx, 0);
+    } else {
+      try_jump(1, 0);
+      try_jump(-1, 0);
+      try_jump(0, dy);
+    }
+  }
+
+  // Walks from (x, y) in the direction while the tile is not a jump
+  // point. Moves along x only stop at forced neighbours, moves along y
+  // also stop where a move along x finds a jump point.
+  int jump(int x, int y, int dx, int dy) const {
+    while (true) {
+      x += dx;
+      y += dy;
+      if (!walkable(x, y)) {
+        return -1;
+      }
+      if (x == tx && y == ty) {
+        return index(x, y);
+      }
+      if (dx != 0) {
+        if ((walkable(x, y - 1) && !walkable(x - dx, y - 1)) ||
+            (walkable(x, y + 1) && !walkable(x - dx, y + 1))) {
+          return index(x, y);
+        }
+      } else {
+        if ((walkable(x - 1, y) && !walkable(x - 1, y - dy)) ||
+            (walkable(x + 1, y) && !walkable(x + 1, y - dy))) {
+          return index(x, y);
+        }
+        if (jump(x, y, 1, 0) != -1 || jump(x, y, -1, 0) != -1) {
+          return index(x, y);
+        }
+      }
+    }
+  }
+
+  /* Unrolls jumps into single steps. */
+  void build_path(int i, std::vector<Cell>& path) const {
+    for (; i != -1; i = nodes[i].parent) {
+      Cell to{lx + i / size, ly + i % size};
+      path.push_back(to);
+      int parent = nodes[i].parent;
+      if (parent == -1) {
+        break;
+      }
+      Cell from{lx + parent / size, ly + parent % size};
+      int dx = (from.x > to.x) - (from.x < to.x);
+      int dy = (from.y > to.y) - (from.y < to.y);
+      for (Cell c{to.x + dx, to.y + dy}; !(c == from);
+           c.x += dx, c.y += dy) {
+        path.push_back(c);
+      }
+    }
+    std::reverse(path.begin(), path.end());
+  }
+
+  void prepare(size_t area) {
+    if (nodes.size() < area) {
+      nodes.resize(area);
+      seen.assign(area, 0);
+      closed.assign(area, 0);
+      epoch = 0;
+    }
+    /* Stamps of previous searches become stale without clearing. */
+    if (++epoch == 0) {
+      std::fill(seen.begin(), seen.end(), 0);
+      std::fill(closed.begin(), closed.end(), 0);
+      epoch = 1;
+    }
+  }
+
+  const BitGridView* obstacles = nullptr;
+  int lx = 0, ly = 0, size = 0;
+  int tx = 0, ty = 0;
+
+  std::vector<Node> nodes;
+  std::vector<uint32_t> seen;
+  std::vector<uint32_t> closed;
+  uint32_t epoch = 0;
+  std::vector<Open> open;
+};
+
+/* Search buffers shared by all path queries of a thread. */
+inline Pathfinder& shared_pathfinder() {
+  thread_local Pathfinder pathfinder;
+  return pathfinder;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Set of tiles within a bounding box, stored as a bit mask with
+// one bit per tile. Membership test is O(1), iteration goes over
+// the mask row by row and skips empty words.
+struct Region {
+  Region() = default;
+
+  /* Empty region over x in [lx, lx + h), y in [ly, ly + w). */
+  Region(int lx, int ly, int h, int w)
+      : lx{lx}, ly{ly}, h{h}, w{w},
+        stride{(static_cast<size_t>(w) + 63) / 64},
+        words(stride * h) {}
+
+  /* Empties the region and moves it over x in [lx, lx + h),
+   * y in [ly, ly + w). The mask storage is kept, so a region reused
+   * for boxes no larger than before does not allocate.
+   */
+  void reset(int lx, int ly, int h, int w) {
+    this->lx = lx;
+    this->ly = ly;
+    this->h = h;
+    this->w = w;
+    stride = (static_cast<size_t>(w) + 63) / 64;
+    count = 0;
+    words.assign(stride * h, 0);
+  }
+
+  /* Empties the region, keeps the storage. */
+  void clear() { reset(0, 0, 0, 0); }
+
+  bool contains(int x, int y) const {
+    if (x < lx || lx + h <= x || y < ly || ly + w <= y) {
+      return false;
+    }
+    size_t bit = static_cast<size_t>(y - ly);
+    return (words[static_cast<size_t>(x - lx) * stride + bit / 64] >>
+            (bit % 64)) & 1;
+  }
+
+  /* Tile must be inside the bounding box. */
+  void insert(int x, int y) {
+    size_t bit = static_cast<size_t>(y - ly);
+    auto& word = words[static_cast<size_t>(x - lx) * stride + bit / 64];
+    uint64_t mask = uint64_t{1} << (bit % 64);
+    count += !(word & mask);
+    word |= mask;
+  }
+
+  /* Adds bits of the `j`-th word of row `i`, bit `b` of the word
+   * is tile (lx + i, ly + 64 * j + b). Bits beyond the width must be 0.
+   */
+  void insert_word(int i, size_t j, uint64_t bits) {
+    auto& word = words[static_cast<size_t>(i) * stride + j];
+    count += __builtin_popcountll(bits & ~word);
+    word |= bits;
+  }
+
+  /* Words per row. */
+  size_t row_words() const { return stride; }
+
+  size_t size() const { return count; }
+
+  bool empty() const { return count == 0; }
+
+  // Calls `f(x, y)` for each tile, rows go in increasing order.
+  template <typename F>
+  void for_each(F&& f) const {
+    for (int i = 0; i < h; ++i) {
+      for (size_t j = 0; j < stride; ++j) {
+        uint64_t word = words[static_cast<size_t>(i) * stride + j];
+        while (word != 0) {
+          int bit = __builtin_ctzll(word);
+          word &= word - 1;
+          f(lx + i, ly + static_cast<int>(j * 64) + bit);
+        }
+      }
+    }
+  }
+
+ private:
+  int lx{}, ly{};
+  int h{}, w{};
+  size_t stride{};
+  size_t count{};
+  std::vector<uint64_t> words;
+};
@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "grid.h"
+
+// Tiles claimed by moves during one turn. Open addressing over a table
+// of at least twice the count of tiles; a new turn bumps the epoch
+// instead of clearing the table.
+struct ReservationTable {
+  /* A step of a mob from one tile to another. */
+  struct Move {
+    int from_x, from_y;
+    int to_x, to_y;
+  };
+
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  /* Forgets all claims, makes room for `tiles` of them. */
+  void reset(size_t tiles) {
+    size_t capacity = 16;
+    while (capacity < 2 * tiles) {
+      capacity *= 2;
+    }
+    if (capacity > slots.size()) {
+      slots.assign(capacity, Slot{});
+      epoch = 0;
+    }
+    mask = slots.size() - 1;
+    ++epoch;
+  }
+
+  /* Claims (x, y) for `mover`, false if the tile is already claimed. */
+  bool claim(int x, int y, uint32_t mover = 0) {
+    auto& slot = find(x, y);
+    if (slot.claimant != NONE) {
+      return false;
+    }
+    slot.claimant = mover;
+    return true;
+  }
+
+  // Settles the moves of a round in O(moves), each tile holding one mob
+  // at most. Of moves into the same tile the first one of the list wins,
+  // the others stay. A move into a tile which another move leaves goes
+  // if that one goes, so chains of followers move together, and so do
+  // rotations, swaps among them. `occupied(x, y)` tells whether a tile
+  // which no move leaves is held; a move into it stays with all of its
+  // followers. Afterwards `moves(i)` tells whether the i-th move goes.
+  template <typename Occupied>
+  void resolve(const std::vector<Move>& list, Occupied&& occupied) {
+    reset(2 * list.size());
+    states.assign(list.size(), UNKNOWN);
+    for (uint32_t i = 0; i < list.size(); ++i) {
+      find(list[i].from_x, list[i].from_y).leaver = i;
+    }
+    for (uint32_t i = 0; i < list.size(); ++i) {
+      if (!claim(list[i].to_x, list[i].to_y, i)) {
+        states[i] = STAY;
+      }
+    }
+    /* Claims are unique, so a move has one follower at most and the
+     * moves form paths and cycles; each is walked once.
+     */
+    for (uint32_t i = 0; i < list.size(); ++i) {
+      uint32_t j = i;
+      State result = UNKNOWN;
+      chain.clear();
+      while (result == UNKNOWN) {
+        if (states[j] != UNKNOWN) {
+          /* A settled move, or back to the start of a cycle. */
+          result = states[j] == VISITING ? GO : states[j];
+          break;
+        }
+        states[j] = VISITING;
+        chain.push_back(j);
+        uint32_t next = find(list[j].to_x, list[j].to_y).leaver;
+        if (next == NONE) {
+          result = occupied(list[j].to_x, list[j].to_y) ? STAY : GO;
+        } else {
+          j = next;
+        }
+      }
+      for (auto k : chain) {
+        states[k] = result;
+      }
+    }
+  }
+
+  bool moves(size_t i) const { return states[i] == GO; }
+
+ private:
+  enum State : uint8_t { UNKNOWN, VISITING, STAY, GO };
+
+  struct Slot {
+    uint64_t key = 0;
+    uint32_t epoch = 0;
+    uint32_t claimant = NONE;
+    uint32_t leaver = NONE;
+  };
+
+  /* Slot of (x, y), a fresh one if the tile is not in the table. */
+  Slot& find(int x, int y) {
+    uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+                   static_cast<uint32_t>(y);
+    for (size_t i = ChunkKeyHash{}(key) & mask;; i = (i + 1) & mask) {
+      if (slots[i].epoch != epoch) {
+        slots[i] = Slot{key, epoch};
+        return slots[i];
+      }
+      if (slots[i].key == key) {
+        return slots[i];
+      }
+    }
+  }
+
+  std::vector<Slot> slots;
+  size_t mask = 0;
+  uint32_t epoch = 0;
+
+  std::vector<State> states;
+  std::vector<uint32_t> chain;
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+// Random numbers of the engine. A game has one world seed, maps and
+// entities draw from their own streams derived from it, so identical
+// seeds give identical games whatever order or thread things run in.
+
+/* Finalizer of splitmix64, a strong 64-bit mix. */
+inline uint64_t mix64(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/* Seed of the stream `stream` of a generator seeded with `seed`. */
+inline uint64_t stream_seed(uint64_t seed, uint64_t stream) {
+  return mix64(seed ^ mix64(stream + 0x9e3779b97f4a7c15ULL));
+}
+
+/* Stream id of a name, FNV-1a. */
+inline uint64_t stream_id(std::string_view name) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (char c : name) {
+    h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+  }
+  return h;
+}
+
+// Counter-based generator (splitmix64): the n-th number is a hash of
+// the seed plus n. Eight bytes of state, cheap enough for every mob.
+struct SplitMix64 {
+  using result_type = uint64_t;
+
+  SplitMix64() = default;
+  explicit SplitMix64(uint64_t seed) : state{seed} {}
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    return mix64(state += 0x9e3779b97f4a7c15ULL);
+  }
+
+  uint64_t state = 0;
+};
+
+// xoshiro256**, fast general purpose generator for bulk work such as
+// map generation. Its state is filled from the seed by splitmix64.
+struct Xoshiro256 {
+  using result_type = uint64_t;
+
+  explicit Xoshiro256(uint64_t seed) {
+    SplitMix64 init{seed};
+    for (auto& word : s) {
+      word = init();
+    }
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+  }
+
+ private:
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+  uint64_t s[4];
+};
+
+/* Uniform in [0, bound), bound > 0, without modulo bias (Lemire's
+ * multiply and reject, a division only on the rare slow path).
+ */
+template <typename G>
+uint32_t uniform_below(G& gen, uint32_t bound) {
+  uint64_t m = (gen() >> 32) * bound;
+  auto low = static_cast<uint32_t>(m);
+  if (low < bound) {
+    uint32_t threshold = -bound % bound;
+    while (low < threshold) {
+      m = (gen() >> 32) * bound;
+      low = static_cast<uint32_t>(m);
+    }
+  }
+  return static_cast<uint32_t>(m >> 32);
+}
+
+/* Uniform in [l, r]. */
+template <typename G>
+int uniform_int(G& gen, int l, int r) {
+  return l + static_cast<int>(
+                 uniform_below(gen, static_cast<uint32_t>(r - l) + 1));
+}
@@ -0,0 +1,133 @@
+#include "room_graph.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+#include <utility>
+
+int RoomGraph::add_area(int lx, int ly, int ux, int uy) {
+  int id = static_cast<int>(areas.size());
+  areas.push_back(
+      Area{lx, ly, ux, uy, std::pmr::vector<int>{areas.get_allocator()}});
+  const int size = 1 << CELL_SHIFT;
+  for (int x = lx >> CELL_SHIFT; x <= ux >> CELL_SHIFT; ++x) {
+    for (int y = ly >> CELL_SHIFT; y <= uy >> CELL_SHIFT; ++y) {
+      cells[cell_key(x * size, y * size)].push_back(id);
+    }
+  }
+  return id;
+}
+
+void RoomGraph::add_portal(Cell cell, int a, int b) {
+  int id = static_cast<int>(portals.size());
+  portals.push_back(Portal{cell, {a, b}});
+  areas[a].portals.push_back(id);
+  areas[b].portals.push_back(id);
+}
+
+int RoomGraph::find_area(int x, int y) const {
+  auto it = cells.find(cell_key(x, y));
+  if (it == cells.end()) {
+    return -1;
+  }
+  for (int area : it->second) {
+    if (areas[area].contains(x, y)) {
+      return area;
+    }
+  }
+  return -1;
+}
+
+RoomGraph::Cell RoomGraph::center(int area) const {
+  const auto& a = areas[area];
+  return {(a.lx + a.ux) / 2, (a.ly + a.uy) / 2};
+}
+
+/* Scratch of `route`, all of `dist` is INT_MAX between calls. */
+struct RouteScratch {
+  std::vector<int> dist;
+  std::vector<int> prev;
+  std::vector<int> touched;
+  std::vector<std::pair<int, int>> queue;
+};
+
+static int distance(RoomGraph::Cell a, RoomGraph::Cell b) {
+  return std::abs(a.x - b.x) + std::abs(a.y - b.y);
+}
+
+bool RoomGraph::route(Cell from, Cell to,
+                      std::vector<Cell>& waypoints) const {
+  waypoints.clear();
+  int from_area = find_area(from.x, from.y);
+  int to_area = find_area(to.x, to.y);
+  if (from_area == -1 || to_area == -1) {
+    return false;
+  }
+  if (from_area == to_area) {
+    waypoints.push_back(to);
+    return true;
+  }
+
+  /* Dijkstra over portals, the target is the last node. Scratch is
+   * kept between calls and only the nodes touched are reset, so a
+   * route costs by the portals it reaches, not by all of the map.
+   */
+  thread_local RouteScratch scratch;
+  auto& [dist, prev, touched, queue] = scratch;
+  const int target = static_cast<int>(portals.size());
+  if (dist.size() < portals.size() + 1) {
+    dist.resize(portals.size() + 1, INT_MAX);
+    prev.resize(portals.size() + 1, -1);
+  }
+  auto relax = [&](int node, int d, int parent) {
+    if (d < dist[node]) {
+      if (dist[node] == INT_MAX) {
+        touched.push_back(node);
+      }
+      dist[node] = d;
+      prev[node] = parent;
+      queue.push_back({d, node});
+      std::push_heap(queue.begin(), queue.end(), std::greater<>{});
+    }
+  };
+  for (int p : areas[from_area].portals) {
+    relax(p, distance(from, portals[p].cell), -1);
+  }
+  while (!queue.empty()) {
+    std::pop_heap(queue.begin(), queue.end(), std::greater<>{});
+    auto [d, node] = queue.back();
+    queue.pop_back();
+    if (d != dist[node]) {
+      continue;
+    }
+    if (node == target) {
+      break;
+    }
+    const auto& portal = portals[node];
+    for (int area : portal.areas) {
+      if (area == to_area) {
+        relax(target, d + distance(portal.cell, to), node);
+      }
+      for (int p : areas[area].portals) {
+        relax(p, d + distance(portal.cell, portals[p].cell), node);
+      }
+    }
+  }
+  bool found = dist[target] != INT_MAX;
+  if (found) {
+    waypoints.push_back(to);
+    for (int p = prev[target]; p != -1; p = prev[p]) {
+      waypoints.push_back(portals[p].cell);
+    }
+    std::reverse(waypoints.begin(), waypoints.end());
+  }
+  for (int node : touched) {
+    dist[node] = INT_MAX;
+    prev[node] = -1;
+  }
+  touched.clear();
+  queue.clear();
+  return found;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+#include "grid.h"
+#include "pathfinder.h"
+
+// Rooms and tunnels of a generated map as a graph. Every room and every
+// tunnel is a free rectangle (an area). Areas are joined by portals:
+// doors between rooms and tunnels, and crossings of tunnels. Inside an
+// area the distance between two tiles is Manhattan, so a route is
+// found over the portals alone and refined only along its legs.
+struct RoomGraph {
+  using Cell = Pathfinder::Cell;
+
+  /* Areas and portals are taken from `resource`. */
+  explicit RoomGraph(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : areas{resource}, portals{resource}, cells{resource} {}
+
+  bool empty() const { return areas.empty(); }
+
+  /* Free tiles with x in [lx, ux] and y in [ly, uy]. */
+  int add_area(int lx, int ly, int ux, int uy);
+
+  void add_portal(Cell cell, int a, int b);
+
+  /* Area which contains the tile, -1 if none. Looks through the few
+   * areas in the cell of the tile.
+   */
+  int find_area(int x, int y) const;
+
+  bool in_area(int area, int x, int y) const {
+    return areas[area].contains(x, y);
+  }
+
+  size_t area_count() const { return areas.size(); }
+
+  /* Center of an area. */
+  Cell center(int area) const;
+
+  // Shortest route from one tile to another over the portals. On
+  // success `waypoints` holds the portals to pass and the target,
+  // consecutive waypoints share an area.
+  bool route(Cell from, Cell to, std::vector<Cell>& waypoints) const;
+
+ private:
+  struct Area {
+    int lx, ly, ux, uy;
+    std::pmr::vector<int> portals;
+
+    bool contains(int x, int y) const {
+      return lx <= x && x <= ux && ly <= y && y <= uy;
+    }
+  };
+
+  struct Portal {
+    Cell cell;
+    int areas[2];
+  };
+
+  std::pmr::vector<Area> areas;
+  std::pmr::vector<Portal> portals;
+
+  /* Cells are a bit larger than rooms, a room or a tunnel is in a few
+   * of them.
+   */
+  static constexpr int CELL_SHIFT = 4;
+
+  static uint64_t cell_key(int x, int y) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x >> CELL_SHIFT))
+            << 32) |
+           static_cast<uint32_t>(y >> CELL_SHIFT);
+  }
+
+  /* Areas which intersect each cell in the order they were added, so
+   * crossings keep the first area.
+   */
+  std::pmr::unordered_map<uint64_t, std::pmr::vector<int>, ChunkKeyHash>
+      cells;
+};
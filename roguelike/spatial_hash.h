@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+#include "entities.h"
+#include "grid.h"
+
+/* Buckets are small squares, a proximity query touches
+ * a few of them and only the entities close to the area.
+ */
+const int BUCKET_SHIFT = 3;
+
+// Entity handles bucketed by position in uniform square cells.
+// Positions themselves are kept by the owner, the hash only knows
+// which bucket each entity is in.
+struct SpatialHash {
+  using Handle = IGameState::ObjectHandle;
+
+  /* Buckets are taken from `resource`. */
+  explicit SpatialHash(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : buckets{resource} {}
+
+  void insert(Handle handle, int x, int y) {
+    buckets[bucket_key(x, y)].push_back(handle);
+  }
+
+  void erase(Handle handle, int x, int y) {
+    auto& bucket = buckets[bucket_key(x, y)];
+    for (auto& other : bucket) {
+      if (other == handle) {
+        other = bucket.back();
+        bucket.pop_back();
+        return;
+      }
+    }
+  }
+
+  /* Most moves stay inside a bucket and cost nothing. */
+  void move(Handle handle, int from_x, int from_y, int to_x, int to_y) {
+    if (bucket_key(from_x, from_y) == bucket_key(to_x, to_y)) {
+      return;
+    }
+    erase(handle, from_x, from_y);
+    insert(handle, to_x, to_y);
+  }
+
+  // Calls `f(handle)` for each entity in the buckets which intersect
+  // x in [lx, ux), y in [ly, uy). The caller filters by exact position.
+  template <typename F>
+  void for_each_candidate(int lx, int ly, int ux, int uy, F&& f) const {
+    if (lx >= ux || ly >= uy) {
+      return;
+    }
+    for (int bx = lx >> BUCKET_SHIFT; bx <= (ux - 1) >> BUCKET_SHIFT; ++bx) {
+      for (int by = ly >> BUCKET_SHIFT; by <= (uy - 1) >> BUCKET_SHIFT;
+           ++by) {
+        auto it = buckets.find(key(bx, by));
+        if (it == buckets.end()) {
+          continue;
+        }
+        for (auto handle : it->second) {
+          f(handle);
+        }
+      }
+    }
+  }
+
+ private:
+  static uint64_t key(int bx, int by) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(bx)) << 32) |
+           static_cast<uint32_t>(by);
+  }
+
+  static uint64_t bucket_key(int x, int y) {
+    return key(x >> BUCKET_SHIFT, y >> BUCKET_SHIFT);
+  }
+
+  /* Emptied buckets are kept, entities tend to come back. */
+  std::pmr::unordered_map<uint64_t, std::pmr::vector<Handle>, ChunkKeyHash>
+      buckets;
+};
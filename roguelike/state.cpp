@@ -1,9 +1,11 @@
-
-
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 
 #include "entities.h"
 #include "map.h"
+#include "rng.h"
+#include "worker_pool.h"
 
 /* GameState impl. */
 GameState::GameState(std::unique_ptr<World> world) : world{std::move(world)} {
@@ -15,18 +17,29 @@ GameState::GameState(std::unique_ptr<World> world) : world{std::move(world)} {
 }
 
 void GameState::map_init(Map *map) {
-    for (const auto object : map->objects) {
+    for (const auto object : map->entities.objects) {
       auto as_state_object = dynamic_cast<GameStateObject*>(object);
       assert(as_state_object && "world contains specific objects");
       as_state_object->set_state(this);
     }
+    world->player->set_state(this);
 }
 
 IGameState::IPlayer* GameState::get_player() const {
   return world->player.get();
 }
 
+IGameState::Object* GameState::get_object(ObjectHandle handle) const {
+  if (handle == PLAYER_HANDLE) {
+    return world->player.get();
+  }
+  return get_current_map()->entities.get(handle);
+}
+
 void GameState::apply_event(const Event& event) {
+  auto start = Deadline::Clock::now();
+  auto deadline =
+      metrics.budget.count() == 0 ? Deadline{} : Deadline{metrics.budget};
   switch (event.type) {
     case EventType::PlayerMove:
       player_move(event.player_move);
@@ -50,18 +63,82 @@ void GameState::apply_event(const Event& event) {
     default:
       break;
   }
-  for (const auto& mob : get_current_map()->mobs) {
-    mob->move();
+  move_mobs();
+  /* Objects destroyed during the turn are removed only now,
+   * the player may have left the map they were on.
+   */
+  for (const auto& map : world->maps) {
+    map->compact();
+  }
+  /* Deferred jobs get what is left of the budget. */
+  metrics.job_slices += jobs.run(deadline);
+  metrics.pending_jobs = jobs.size();
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      Deadline::Clock::now() - start);
+  metrics.last_turn = elapsed;
+  metrics.worst_turn = std::max(metrics.worst_turn, elapsed);
+  ++metrics.turns;
+  if (metrics.budget.count() != 0 && elapsed > metrics.budget) {
+    ++metrics.deadline_misses;
+  }
+}
+
+/* Idle work runs in slices short enough not to delay a keypress. */
+const auto IDLE_SLICE = std::chrono::milliseconds{2};
+
+bool GameState::run_idle() {
+  metrics.job_slices += jobs.run(Deadline{IDLE_SLICE});
+  metrics.pending_jobs = jobs.size();
+  return jobs.size() != 0;
+}
+
+void GameState::set_turn_budget(std::chrono::microseconds budget) {
+  metrics.budget = budget;
+}
+
+void GameState::set_action_budget(uint64_t actions) {
+  metrics.action_budget = actions;
+}
+
+const TurnMetrics& GameState::get_metrics() const { return metrics; }
+
+/* Mobs further than this from the player do not chase or flee it. */
+const int ACTIVE_RADIUS = 24;
+
+void GameState::update_player_distance() {
+  auto map = get_current_map();
+  auto [x, y] = world->player->get_pos();
+  if (player_distance_map == map &&
+      player_distance_version == map->get_version() &&
+      player_distance.origin_x() == x && player_distance.origin_y() == y) {
+    return;
   }
+  player_distance.build(map->get_obstacles(), x, y, ACTIVE_RADIUS);
+  player_distance_map = map;
+  player_distance_version = map->get_version();
+}
+
+const DistanceField& GameState::get_player_distance() const {
+  return player_distance;
+}
+
+void GameState::move_mobs() {
+  /* Killed mobs stay in the map until the turn ends, tick skips them. */
+  update_player_distance();
+  auto [x, y] = world->player->get_pos();
+  auto budget = metrics.action_budget == 0
+                    ? ActionBudget{}
+                    : ActionBudget{metrics.action_budget};
+  metrics.deferred_mobs += DecisionTreeMob::tick(*get_current_map(), x, y,
+                                                 shared_pool(), budget);
 }
 
 Map* GameState::get_current_map() const { return map_stack.back().map; }
 
 void GameState::player_move(const PlayerMoveEvent& event) {
+  /* Mobs act after every event, see `apply_event`. */
   world->player->move(event);
-  for (const auto& mob : get_current_map()->mobs) {
-    mob->move();
-  }
 }
 
 const int MAX_LEVEL = 5;
@@ -74,10 +151,37 @@ const IGameState::MapDescription GameState::get_map() const {
   auto map = map_stack.back().map;
   return IGameState::MapDescription{
       .name = map->name,
-      .objects = map->objects,
+      .objects = map->entities.objects,
+      .handles = map->entities.handles,
+      .xs = map->entities.xs,
+      .ys = map->entities.ys,
   };
 }
 
+IGameState::Terrain GameState::get_terrain(int x, int y) const {
+  return map_stack.back().map->get_terrain(x, y);
+}
+
+void GameState::query_rect(int lx, int ly, int ux, int uy,
+                           std::vector<ObjectHandle>& out) const {
+  get_current_map()->query_rect(
+      lx, ly, ux, uy,
+      [&](ObjectHandle handle, Object*) { out.push_back(handle); });
+  auto [x, y] = world->player->get_pos();
+  if (lx <= x && x < ux && ly <= y && y < uy) {
+    out.push_back(PLAYER_HANDLE);
+  }
+}
+
+/* Stream of the map behind an enter: the map the enter stands on and
+ * its place there, so each enter of a world leads to its own map.
+ */
+static uint64_t enter_stream(const std::string& map_name, int x, int y) {
+  return stream_id(map_name) ^
+         mix64((static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+               static_cast<uint32_t>(y));
+}
+
 void GameState::move_on(Map* map) {
   assert(map != nullptr);
   auto [x, y] = world->player->get_pos();
@@ -85,24 +189,39 @@ void GameState::move_on(Map* map) {
   auto [sx, sy] = map->start_pos();
   world->player->set_pos(sx, sy);
 
-  //generate maps
+  /* Maps behind enters are generated when there is time for it,
+   * or at once when the player takes the enter first. A map of 15
+   * rooms takes some 40 us, well within a slice, so it is one job.
+   */
   for (auto &enter : map->enters) {
     if (enter->get_map() == nullptr) {
-      auto label = enter->get_label();
-      auto filename = std::string{label->begin(), label->end()};
-      filename += ".rl";
-      auto file = world->dir / filename;
-      if (!std::filesystem::exists(file)) {
-        auto generated_map = gen_map(15);
-        generated_map->push_player(world->player.get());
-        map_init(generated_map.get());
-        enter->set_map(generated_map.get());
-        world->maps.push_back(std::move(generated_map));
-      }
+      jobs.push([this, target = enter.get()] {
+        generate_map(target);
+        return true;
+      });
     }
   }
 }
 
+void GameState::generate_map(Enter* enter) {
+  if (enter->get_map() != nullptr) {
+    return;
+  }
+  auto label = enter->get_label();
+  auto filename = std::string{label->begin(), label->end()};
+  filename += ".rl";
+  auto file = world->dir / filename;
+  if (!std::filesystem::exists(file)) {
+    auto [x, y] = enter->get_pos();
+    auto generated_map = gen_map(
+        15, stream_seed(world->seed, enter_stream(enter->owner->name, x, y)));
+    generated_map->push_player(world->player.get());
+    map_init(generated_map.get());
+    enter->set_map(generated_map.get());
+    world->maps.push_back(std::move(generated_map));
+  }
+}
+
 void GameState::move_back() {
   if (map_stack.size() > 1) {
     world->player->set_pos(map_stack.back().x, map_stack.back().y);
@@ -111,7 +230,7 @@ void GameState::move_back() {
 }
 
 void GameState::apply(const ApplyObjectEvent& e) {
-  auto object = dynamic_cast<GameStateObject*>(e.object);
+  auto object = dynamic_cast<GameStateObject*>(get_object(e.object));
   if (object != nullptr) object->apply();
 }
 
@@ -120,3 +239,16 @@ void GameState::apply(const ApplyObjectEvent& e) {
 void GameStateObject::set_state(GameState* state) { this->state = state; }
 
 GameState* GameStateObject::get_state() const { return state; }
+
+uint32_t GameStateObject::column() const {
+  return owner == nullptr ? NOT_PLACED : owner->entities.find(entity);
+}
+
+std::tuple<int, int> GameStateObject::column_pos(
+    const IGameState::Object& self) const {
+  auto i = column();
+  if (i == NOT_PLACED) {
+    return self.IGameState::Object::get_pos();
+  }
+  return {owner->entities.xs[i], owner->entities.ys[i]};
+}
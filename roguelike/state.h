@@ -1,50 +1,79 @@
 #pragma once
+#include <chrono>
+
+#include "distance_field.h"
 #include "entities.h"
+#include "turn_budget.h"
 
 struct Map;
 struct World;
 
 struct Player;
-struct Wall;
-struct DungeonBlock;
 struct Mob;
 struct Enter;
 struct Exit;
-struct Border;
 struct Chest;
 struct Orc;
 struct Bat;
 
 struct GameState : IGameState {
   friend class Player;
-  friend class Wall;
-  friend class DungeonBlock;
   friend class Mob;
   friend class Enter;
   friend class Exit;
-  friend class Border;
   friend class Orc;
   friend class Bat;
   friend class ItemObject;
 
   GameState(std::unique_ptr<World> world);
   const MapDescription get_map() const override;
+  Terrain get_terrain(int x, int y) const override;
+  void query_rect(int lx, int ly, int ux, int uy,
+                  std::vector<ObjectHandle>& out) const override;
   void map_init(Map *map);
   IGameState::IPlayer* get_player() const override;
+  Object* get_object(ObjectHandle handle) const override;
 
   void apply_event(const Event& event) override;
 
+  bool run_idle() override;
+
+  /* Wall clock budget of a turn, zero for none. Deferred jobs wait
+   * when it is spent; they do not change the game, so it is still
+   * reproduced by its seed.
+   */
+  void set_turn_budget(std::chrono::microseconds budget);
+
+  /* Mob actions in a turn, zero for no limit. The player and mobs
+   * around it act whatever it takes; far mobs wait for the next turn
+   * once the budget is spent. It is counted in actions rather than
+   * time, so a game is reproduced by its seed on any machine.
+   */
+  void set_action_budget(uint64_t actions);
+
+  const TurnMetrics& get_metrics() const;
+
   Map* get_current_map() const;
 
   void damage_player(int dmg);
 
+  /* Distances from the player on the current map, valid for the turn. */
+  const DistanceField& get_player_distance() const;
+
   bool is_win() const override;
 
  private:
   void player_move(const PlayerMoveEvent& event);
 
+  void move_mobs();
+
+  void update_player_distance();
+
   void move_on(Map* map);
 
+  /* Generates the map behind an enter, unless it has one already. */
+  void generate_map(Enter* enter);
+
   void move_back();
 
   void apply(const ApplyObjectEvent& e);
@@ -58,11 +87,23 @@ struct GameState : IGameState {
 
   std::unique_ptr<World> world;
   std::vector<MapStackNode> map_stack;
+
+  /* Shared by all mobs, rebuilt only when the player, the map
+   * or its obstacles change.
+   */
+  DistanceField player_distance;
+  const Map* player_distance_map = nullptr;
+  uint64_t player_distance_version = 0;
+
+  /* Work which may be late: generation of maps behind enters. */
+  JobQueue jobs;
+  TurnMetrics metrics;
 };
 
 // Objects of concrete state `GameState`.
 struct GameStateObject {
   friend class GameState;
+  friend class Map;
 
   GameStateObject() = default;
 
@@ -76,5 +117,20 @@ struct GameStateObject {
   GameState* get_state() const;
 
  protected:
+  /* Index of the object in the columns of its map, `NOT_PLACED` before
+   * it is added to a map and after it is removed.
+   */
+  static constexpr uint32_t NOT_PLACED = UINT32_MAX;
+  uint32_t column() const;
+
+  /* Position in the columns of the map, the own one of `self` while
+   * not placed.
+   */
+  std::tuple<int, int> column_pos(const IGameState::Object& self) const;
+
   GameState* state{};
+
+  /* Map which owns the object and its entity there. */
+  Map* owner{};
+  IGameState::ObjectHandle entity{};
 };
@@ -0,0 +1,116 @@
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+#include "activity.h"
+#include "objects.h"
+#include "room_graph.h"
+
+int main() {
+  EntityStore entities;
+  RoomGraph rooms;
+  Activity activity;
+  std::vector<Activity::Pick> picks;
+  const auto& config = activity.config;
+
+  /* A mob out of the wake radius sleeps. */
+  Bat bat{50, 0};
+  auto handle = entities.push(&bat);
+  activity.add(handle, 50, 0);
+  activity.begin_turn(entities, 0, 0);
+  assert(!activity.next_round(entities, rooms, 0, 0, picks));
+  assert(activity.awake_count() == 0);
+
+  /* The player enters its zone, the mob wakes and acts at once. */
+  int px = 50 - config.wake_radius;
+  activity.begin_turn(entities, px, 0);
+  assert(activity.awake_count() == 1);
+  assert(activity.next_round(entities, rooms, px, 0, picks));
+  assert(picks.size() == 1 && picks[0].index == entities.index(handle));
+  /* Further than the interest radius it thinks coarsely. */
+  assert(picks[0].coarse);
+  activity.schedule(handle, TURN_TIME, picks[0].coarse);
+  assert(!activity.next_round(entities, rooms, px, 0, picks));
+
+  /* Close to the player, or in its room, it thinks fully. */
+  for (int turn = 0; turn < config.coarse_period; ++turn) {
+    activity.begin_turn(entities, 50 - config.interest_radius, 0);
+  }
+  assert(activity.next_round(entities, rooms, 50 - config.interest_radius, 0,
+                             picks));
+  assert(picks.size() == 1 && !picks[0].coarse);
+  activity.schedule(handle, TURN_TIME, false);
+  int room = rooms.add_area(20, -5, 60, 5);
+  activity.begin_turn(entities, 20, 0);
+  assert(activity.next_round(entities, rooms, 20, 0, picks));
+  assert(rooms.find_area(20, 0) == room && !picks[0].coarse);
+  activity.schedule(handle, TURN_TIME, false);
+
+  /* The player goes away, the mob falls asleep when it is due. */
+  activity.begin_turn(entities, 50 - config.dormant_radius - 1, 0);
+  assert(!activity.next_round(entities, rooms,
+                              50 - config.dormant_radius - 1, 0, picks));
+  assert(activity.awake_count() == 0);
+  activity.begin_turn(entities, 0, 0);
+  assert(!activity.next_round(entities, rooms, 0, 0, picks));
+
+  /* And wakes again when the player comes back. */
+  activity.begin_turn(entities, 50, 0);
+  assert(activity.next_round(entities, rooms, 50, 0, picks));
+  assert(picks.size() == 1);
+
+  /* Bats act three times per two actions of orcs, each mob at most
+   * once per round.
+   */
+  Activity schedule;
+  EntityStore crowd;
+  std::vector<Bat> bats;
+  std::vector<Orc> orcs;
+  for (int i = 0; i < 10; ++i) {
+    bats.emplace_back(1, i);
+    orcs.emplace_back(2, i);
+  }
+  std::vector<DecisionTreeMob*> mobs;
+  for (int i = 0; i < 10; ++i) {
+    mobs.push_back(&bats[i]);
+    mobs.push_back(&orcs[i]);
+  }
+  for (auto mob : mobs) {
+    auto [x, y] = mob->get_pos();
+    schedule.add(crowd.push(mob), x, y);
+  }
+  assert(bats[0].get_delay() * 3 == 2 * TURN_TIME);
+  assert(orcs[0].get_delay() == TURN_TIME);
+  std::vector<int> actions(crowd.size()), before(crowd.size());
+  const int turns = 12;
+  for (int turn = 0; turn < turns; ++turn) {
+    schedule.begin_turn(crowd, 0, 0);
+    while (schedule.next_round(crowd, rooms, 0, 0, picks)) {
+      for (size_t k = 0; k < picks.size(); ++k) {
+        assert(k == 0 || picks[k - 1].index < picks[k].index);
+        auto i = picks[k].index;
+        ++actions[i];
+        schedule.schedule(
+            crowd.handles[i],
+            static_cast<DecisionTreeMob*>(crowd.objects[i])->get_delay(),
+            picks[k].coarse);
+      }
+    }
+    /* The first pair of turns is short of a bat action, the mobs
+     * wake only at the end of the first turn.
+     */
+    if (turn % 2 == 1 && turn > 1) {
+      for (size_t i = 0; i < crowd.size(); ++i) {
+        bool is_bat =
+            crowd.descriptors[i] == IGameState::ObjectDescriptor::BAT;
+        assert(actions[i] - before[i] == (is_bat ? 3 : 2));
+      }
+    }
+    if (turn % 2 == 1) {
+      before = actions;
+    }
+  }
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
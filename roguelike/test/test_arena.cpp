@@ -0,0 +1,87 @@
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "arena.h"
+#include "grid.h"
+#include "map.h"
+#include "state.h"
+#include "test/world_fixture.h"
+
+int main() {
+  /* Large blocks are reused by size, small ones come from the pool. */
+  Arena arena{64 * 1024};
+  auto resource = arena.resource();
+  void* chunk = resource->allocate(4120, 8);
+  void* other = resource->allocate(4120, 8);
+  resource->deallocate(chunk, 4120, 8);
+  assert(resource->allocate(4120, 8) == chunk);
+  assert(resource->allocate(4120, 8) != other);
+  void* small = resource->allocate(24, 8);
+  resource->deallocate(small, 24, 8);
+  resource->deallocate(other, 4120, 8);
+  assert(arena.system_allocations() == 1);
+
+  /* Grids take their chunks from the arena and give them back. */
+  {
+    Grid<uint16_t> grid{resource};
+    for (int x = 0; x < 4 * CHUNK_SIZE; x += CHUNK_SIZE) {
+      grid.at(x, 0) = 1;
+    }
+    assert(grid.chunk_count() == 4);
+  }
+  {
+    Grid<uint16_t> grid{resource};
+    for (int x = 0; x < 4 * CHUNK_SIZE; x += CHUNK_SIZE) {
+      grid.at(x, 0) = 1;
+    }
+    assert(grid.get(0, 0) == 1 && grid.get(0, 1) == 0);
+  }
+  assert(arena.system_allocations() == 1);
+
+  /* Generated maps take a few blocks of the system, however many
+   * rooms they have.
+   */
+  for (int rooms : {1, 15, 240, 1000}) {
+    for (uint64_t seed = 0; seed < 3; ++seed) {
+      auto map = gen_map(rooms, seed);
+      assert(map->system_allocations() <= 4);
+    }
+  }
+
+  /* Large blocks of more sizes than a few, freed and taken again and
+   * again, take no more of the system than the first round did.
+   */
+  Arena churn{64 * 1024};
+  std::vector<void*> live;
+  size_t first_round = 0;
+  for (int round = 0; round < 100; ++round) {
+    for (size_t size = 512; size < 512 + 40 * 64; size += 64) {
+      live.push_back(churn.resource()->allocate(size, 8));
+    }
+    for (size_t i = 0; i < live.size(); ++i) {
+      churn.resource()->deallocate(live[i], 512 + i * 64, 8);
+    }
+    live.clear();
+    if (round == 0) {
+      first_round = churn.system_allocations();
+    }
+  }
+  assert(churn.system_allocations() == first_round);
+
+  /* Neither do the mobs of a map played for long. */
+  auto dir = make_world("test_arena", {.objects = 400});
+  GameState state{std::make_unique<World>(dir, 3)};
+  for (int turn = 0; turn < 2000; ++turn) {
+    state.apply_event(IGameState::NoOpEvent{});
+    if (turn == 200) {
+      first_round = state.get_current_map()->system_allocations();
+    }
+  }
+  assert(state.get_current_map()->system_allocations() == first_round);
+  std::filesystem::remove_all(dir);
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
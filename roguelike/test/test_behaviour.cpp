@@ -0,0 +1,161 @@
+#include <cassert>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <tuple>
+
+#include "arena.h"
+#include "behaviour.h"
+#include "map.h"
+#include "state.h"
+#include "test/world_fixture.h"
+
+namespace fs = std::filesystem;
+
+/* Bytes taken and not given back, frames freed with another size than
+ * they got show here.
+ */
+struct FrameCheck : std::pmr::memory_resource {
+  size_t live_bytes = 0;
+
+ private:
+  void* do_allocate(size_t size, size_t alignment) override {
+    live_bytes += size;
+    return std::pmr::new_delete_resource()->allocate(size, alignment);
+  }
+
+  void do_deallocate(void* p, size_t size, size_t alignment) override {
+    live_bytes -= size;
+    std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const
+      noexcept override {
+    return this == &other;
+  }
+};
+
+#pragma GCC diagnostic push
+/* The frame header makes the delete match, see orc_behaviour. */
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+Behaviour count_steps(std::allocator_arg_t, std::pmr::memory_resource*,
+                      int& steps) {
+  while (true) {
+    ++steps;
+    co_await next_step();
+  }
+}
+#pragma GCC diagnostic pop
+
+int main() {
+  /* A frame is freed with the size it got. */
+  FrameCheck frames;
+  int steps = 0;
+  {
+    auto behaviour = count_steps(std::allocator_arg, &frames, steps);
+    behaviour.resume();
+    assert(steps == 1 && frames.live_bytes > 0);
+  }
+  assert(frames.live_bytes == 0);
+
+  /* Freed frames are reused. */
+  CountingResource upstream;
+  std::pmr::unsynchronized_pool_resource pool{&upstream};
+  size_t allocations = 0;
+  for (int i = 0; i < 100; ++i) {
+    auto behaviour = count_steps(std::allocator_arg, &pool, steps);
+    behaviour.resume();
+    if (i == 0) {
+      allocations = upstream.allocations;
+    }
+  }
+  assert(steps == 101);
+  assert(upstream.allocations == allocations);
+
+  /* An orc at (8, 12) and a closed room next to it, where the player
+   * may hide.
+   */
+  const std::string wall = "                    +---+\n";
+  const std::string room = "                    |   |\n";
+  auto dir = write_world("test_behaviour",
+                         "%" + wall.substr(1) + room + room + room + wall +
+                             "\n\n\n            $\n");
+  GameState state{std::make_unique<World>(dir, 1)};
+  auto player = state.get_player();
+  IGameState::Object* orc = nullptr;
+  for (auto object : state.get_map().objects) {
+    if (object->get_descriptor() == IGameState::ObjectDescriptor::ORC) {
+      orc = object;
+    }
+  }
+  assert(orc != nullptr);
+  const int sx = 8, sy = 12;
+  auto from_spawn = [&] {
+    auto [x, y] = orc->get_pos();
+    return std::abs(x - sx) + std::abs(y - sy);
+  };
+
+  /* Out of sight of the player the orc wanders near its spawn. */
+  for (int i = 0; i < 20; ++i) {
+    state.apply_event(IGameState::NoOpEvent{});
+    assert(from_spawn() <= 4);
+  }
+
+  /* Seen, it follows the player away from the spawn. */
+  auto [ox, oy] = orc->get_pos();
+  player->set_pos(ox - 5, oy);
+  for (int i = 0; i < 8; ++i) {
+    state.apply_event(IGameState::PlayerMoveEvent::Up);
+  }
+  assert(from_spawn() > 4);
+
+  /* The player hides, the orc gives up and goes back home. */
+  player->set_pos(2, 22);
+  for (int i = 0; i < 60; ++i) {
+    state.apply_event(IGameState::NoOpEvent{});
+  }
+  assert(from_spawn() <= 4);
+
+  /* Seen once and hidden, the orc goes to where it saw the player. */
+  std::tie(ox, oy) = orc->get_pos();
+  player->set_pos(ox, oy + 5);
+  state.apply_event(IGameState::NoOpEvent{});
+  auto seen = player->get_pos();
+  player->set_pos(2, 22);
+  for (int i = 0; i < 10; ++i) {
+    state.apply_event(IGameState::NoOpEvent{});
+  }
+  assert(orc->get_pos() == seen);
+
+  fs::remove_all(dir);
+
+  /* An orc at (2, 1) with a wall under it. Behind the wall, at the
+   * edge of its reach, the player is not seen and the orc strikes one
+   * step in three.
+   */
+  dir = write_world("test_behaviour_strike", "%\n\n $\n---\n");
+  const int SEEDS = 300;
+  int strikes = 0;
+  for (int seed = 0; seed < SEEDS; ++seed) {
+    GameState strike{std::make_unique<World>(dir)};
+    Orc* lone = nullptr;
+    for (auto object : strike.get_map().objects) {
+      if (auto o = dynamic_cast<Orc*>(object); o != nullptr) {
+        lone = o;
+      }
+    }
+    assert(lone != nullptr);
+    lone->seed(seed);
+    strike.get_player()->set_pos(5, 1);
+    lone->move();
+    strikes += lone->intent().kind == Intent::Kind::ATTACK;
+  }
+  assert(SEEDS / 4 < strikes && strikes < SEEDS * 5 / 12);
+
+  fs::remove_all(dir);
+  std::cout << "OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,48 @@
+#include <cassert>
+#include <iostream>
+
+#include "distance_field.h"
+#include "grid.h"
+
+int main() {
+  /* Walls around the origin open to one side, rows are x:
+   *
+   *   . . . . .
+   *   . # # # .
+   *   . . @ # .
+   *   . # # # .
+   *   . . . . .
+   *
+   * and a closed pocket at (11, 11).
+   */
+  BitGrid walls;
+  for (int y = 1; y <= 3; ++y) {
+    walls.set(1, y);
+    walls.set(3, y);
+  }
+  walls.set(2, 3);
+  for (int x = 10; x <= 12; ++x) {
+    for (int y = 10; y <= 12; ++y) {
+      if (x != 11 || y != 11) {
+        walls.set(x, y);
+      }
+    }
+  }
+  DistanceField field;
+  field.build(walls.view(), 2, 2, 12);
+  assert(field.origin_x() == 2 && field.origin_y() == 2);
+  assert(field.get(2, 2) == 0);
+  assert(field.get(2, 1) == 1 && field.get(2, 0) == 2);
+  /* Around the wall, not through it. */
+  assert(field.get(0, 2) == 6);
+  assert(field.get(2, 4) == 10);
+  /* Walls and the pocket can not be reached. */
+  assert(field.get(1, 2) == DistanceField::UNREACHABLE);
+  assert(field.get(11, 11) == DistanceField::UNREACHABLE);
+  /* Out of the window it is Manhattan distance. */
+  assert(field.get(2, 15) == 13);
+  assert(field.get(-20, 2) == 22);
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
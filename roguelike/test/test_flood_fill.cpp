@@ -0,0 +1,56 @@
+#include <cassert>
+#include <iostream>
+#include <random>
+
+#include "flood_fill.h"
+
+/* Both regions hold the same tiles. */
+bool same(const Region& lhs, const Region& rhs) {
+  bool equal = lhs.size() == rhs.size();
+  lhs.for_each([&](int x, int y) { equal = equal && rhs.contains(x, y); });
+  return equal;
+}
+
+int main() {
+  std::mt19937 gen(7);
+  BitFlood flood;
+  /* Reused by every round, whatever the radius before. */
+  Region reused;
+
+  /* Random obstacles of various density around origins near chunk
+   * borders, radii span several words per row.
+   */
+  for (int round = 0; round < 200; ++round) {
+    BitGrid obstacles;
+    int density = 2 + round % 5;
+    int cx = static_cast<int>(gen() % 200) - 100;
+    int cy = static_cast<int>(gen() % 200) - 100;
+    for (int x = cx - 80; x <= cx + 80; ++x) {
+      for (int y = cy - 80; y <= cy + 80; ++y) {
+        if (gen() % density == 0) {
+          obstacles.set(x, y);
+        }
+      }
+    }
+    int d = round % 3 == 0 ? static_cast<int>(gen() % 80) : round % 12;
+    auto view = obstacles.view();
+    auto expected = flood_fill_reference(view, cx, cy, d);
+    assert(same(flood.run(view, cx, cy, d), expected));
+    flood.run(view, cx, cy, d, reused);
+    assert(same(reused, expected));
+  }
+
+  /* A cleared region holds nothing. */
+  reused.clear();
+  assert(reused.empty() && !reused.contains(0, 0));
+
+  /* Without obstacles the area is the whole diamond. */
+  BitGrid empty;
+  for (int d = 0; d < 70; ++d) {
+    assert(flood.run(empty.view(), 3, -5, d).size() ==
+           static_cast<size_t>(2 * d * (d + 1) + 1));
+  }
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
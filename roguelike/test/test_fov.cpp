@@ -0,0 +1,80 @@
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+
+#include "fov.h"
+#include "grid.h"
+#include "map.h"
+#include "test/world_fixture.h"
+
+namespace fs = std::filesystem;
+
+int main() {
+  /* Nothing in the way: all of the square is seen, nothing past it. */
+  BitGrid walls;
+  FieldOfView view;
+  view.build(walls.view(), 0, 0, 4);
+  for (int x = -4; x <= 4; ++x) {
+    for (int y = -4; y <= 4; ++y) {
+      assert(view.visible(x, y));
+    }
+  }
+  assert(!view.visible(5, 0) && !view.visible(0, -5) && !view.visible(5, 5));
+
+  /* A wall is seen, the tiles behind it are not. */
+  walls.set(0, 3);
+  view.build(walls.view(), 0, 0, 8);
+  assert(view.visible(0, 2) && view.visible(0, 3));
+  assert(!view.visible(0, 4) && !view.visible(0, 8));
+  assert(view.visible(3, 4));
+
+  /* A wall on the diagonal hides the diagonal behind it. */
+  BitGrid corner;
+  corner.set(1, 1);
+  view.build(corner.view(), 0, 0, 8);
+  assert(view.visible(1, 1));
+  assert(!view.visible(2, 2) && !view.visible(3, 3));
+  assert(view.visible(2, 0) && view.visible(0, 2));
+  assert(view.visible(-2, -2));
+
+  /* Between two walls at the sides the diagonal tile is still seen,
+   * the tiles straight behind the walls are not.
+   */
+  BitGrid gap;
+  gap.set(1, 0);
+  gap.set(0, 1);
+  view.build(gap.view(), 0, 0, 8);
+  assert(view.visible(1, 0) && view.visible(0, 1) && view.visible(1, 1));
+  assert(!view.visible(2, 0) && !view.visible(0, 2));
+  assert(view.visible(-1, -1));
+
+  /* Mobs see up to VIEW_RADIUS along both axes. A chest is at (0, 3)
+   * and a wall at (2, 3).
+   */
+  auto dir = write_world("test_fov", "   @\n\n   |\n");
+  Map map{dir / "A.rl"};
+  const int r = Map::VIEW_RADIUS;
+  assert(map.can_see(-3, 0, -3, r) && map.can_see(-3, 0, -3 - r, 0));
+  assert(map.can_see(-3, 0, -3 - r, -r));
+  assert(!map.can_see(-3, 0, -3, r + 1) && !map.can_see(-3, 0, -4 - r, 0));
+
+  /* The cached view follows changes of the obstacles. */
+  assert(!map.can_see(0, 0, 0, 5));
+  Chest* chest = nullptr;
+  map.query_rect(0, 3, 1, 4, [&](IGameState::ObjectHandle,
+                                 IGameState::Object* object) {
+    chest = dynamic_cast<Chest*>(object);
+  });
+  assert(chest != nullptr);
+  auto version = map.get_version();
+  map.destroy_object(chest);
+  assert(map.get_version() != version);
+  assert(map.can_see(0, 0, 0, 5));
+  /* And the point it is looked from. */
+  assert(!map.can_see(1, 3, 4, 3));
+  assert(map.can_see(0, 0, 0, 5));
+
+  fs::remove_all(dir);
+  std::cout << "OK" << std::endl;
+  return 0;
+}
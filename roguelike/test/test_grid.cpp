@@ -0,0 +1,48 @@
+#include <cassert>
+#include <iostream>
+#include <set>
+#include <utility>
+
+#include "grid.h"
+
+int main() {
+  Grid<int> grid;
+  assert(grid.get(0, 0) == 0);
+  assert(grid.chunk_count() == 0);
+
+  /* Neighbouring tiles on both sides of zero land in different chunks. */
+  grid.at(-1, -1) = 1;
+  grid.at(0, 0) = 2;
+  grid.at(-CHUNK_SIZE, CHUNK_SIZE - 1) = 3;
+  grid.at(1 << 20, -(1 << 20)) = 4;
+  assert(grid.get(-1, -1) == 1);
+  assert(grid.get(0, 0) == 2);
+  assert(grid.get(-CHUNK_SIZE, CHUNK_SIZE - 1) == 3);
+  assert(grid.get(1 << 20, -(1 << 20)) == 4);
+  assert(grid.get(-1, 0) == 0);
+  assert(grid.chunk_count() == 4);
+
+  std::set<std::pair<int, int>> visited;
+  grid.for_each([&](int x, int y, int) { visited.insert({x, y}); });
+  assert((visited == std::set<std::pair<int, int>>{
+                         {-1, -1},
+                         {0, 0},
+                         {-CHUNK_SIZE, CHUNK_SIZE - 1},
+                         {1 << 20, -(1 << 20)},
+                     }));
+
+  BitGrid bits;
+  bits.set(-1, -1);
+  bits.set(5, 63);
+  bits.set(5, 64);
+  auto view = bits.view();
+  assert(view.test(-1, -1));
+  assert(view.test(5, 63));
+  assert(view.test(5, 64));
+  assert(!view.test(5, 62));
+  assert(!view.test(-1, 0));
+  assert(!view.test(1000, 1000));
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
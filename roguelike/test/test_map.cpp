@@ -1,8 +1,73 @@
 #include <cassert>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <vector>
+
+#include "map.h"
+#include "state.h"
+#include "test/world_fixture.h"
+
+namespace fs = std::filesystem;
 
 int main() {
-  assert(2 + 2 == 4);
+  /* The exit at (0, 0) and an orc at (2, 2). */
+  auto dir = write_world("test_map", "%\n\n  $\n");
+  GameState state{std::make_unique<World>(dir)};
+  auto map = state.get_current_map();
+
+  IGameState::Object* orc = nullptr;
+  for (auto obj : state.get_map().objects) {
+    if (dynamic_cast<Mob*>(obj) != nullptr) {
+      orc = obj;
+    }
+  }
+  assert(orc != nullptr);
+  assert(map->has_object(2, 2, nullptr));
+  assert(!map->has_object(2, 2, orc));
+
+  /* A move through the base class pointer keeps the map up to date. */
+  orc->set_pos(2, 4);
+  assert(!map->has_object(2, 2, nullptr));
+  assert(map->has_object(2, 4, nullptr));
+  assert(!map->has_object(2, 4, orc));
+
+  /* A move through the derived type counts the orc as a mob, which
+   * does not block the tile.
+   */
+  map->move_object(dynamic_cast<Orc*>(orc), 2, 5);
+  assert(map->has_object(2, 5, nullptr));
+  assert(!map->is_blocked(2, 5));
+  map->move_object(dynamic_cast<Orc*>(orc), 2, 4);
+
+  /* The player is checked apart from the other objects. */
+  state.get_player()->set_pos(1, 1);
+  assert(map->has_object(1, 1, nullptr));
+  assert(!map->has_object(1, 1, state.get_player()));
+
+  /* Queries find the exit at (0, 0) and the orc, the player last. */
+  std::vector<IGameState::ObjectHandle> found;
+  state.query_rect(0, 0, 3, 5, found);
+  assert(found.size() == 3);
+  assert(found.back() == IGameState::PLAYER_HANDLE);
+  found.clear();
+  state.query_rect(2, 0, 3, 5, found);
+  assert(found.size() == 1 && found[0] != IGameState::PLAYER_HANDLE);
+
+  /* A radius covers tiles at Manhattan distance r, not the corners of
+   * the square around it.
+   */
+  std::vector<IGameState::Object*> near;
+  auto collect = [&](EntityStore::Handle, IGameState::Object* obj) {
+    near.push_back(obj);
+  };
+  map->query_radius(2, 2, 2, collect);
+  assert(near.size() == 1 && near[0] == orc);
+  near.clear();
+  map->query_radius(0, 2, 2, collect);
+  assert(near.size() == 1 && dynamic_cast<Exit*>(near[0]) != nullptr);
+
+  fs::remove_all(dir);
   std::cout << "OK" << std::endl;
   return 0;
 }
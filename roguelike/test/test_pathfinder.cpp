@@ -0,0 +1,115 @@
+#include <cassert>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "grid.h"
+#include "pathfinder.h"
+
+int draw(std::mt19937 &gen, int l, int r) {
+  return std::uniform_int_distribution<int>{l, r}(gen);
+}
+
+/* Length in steps of a shortest path inside the square window of
+ * `radius` around the start, -1 if there is none. Plain BFS.
+ */
+int reference(BitGridView obstacles, int sx, int sy, int tx, int ty,
+              int radius) {
+  auto inside = [&](int x, int y) {
+    return std::abs(x - sx) <= radius && std::abs(y - sy) <= radius &&
+           !obstacles.test(x, y);
+  };
+  if (!inside(sx, sy) || !inside(tx, ty)) {
+    return -1;
+  }
+  int size = 2 * radius + 1;
+  std::vector<int> dist(size * size, -1);
+  auto index = [&](int x, int y) {
+    return (x - sx + radius) * size + (y - sy + radius);
+  };
+  std::deque<std::pair<int, int>> queue{{sx, sy}};
+  dist[index(sx, sy)] = 0;
+  const int dx[] = {1, -1, 0, 0};
+  const int dy[] = {0, 0, 1, -1};
+  while (!queue.empty()) {
+    auto [x, y] = queue.front();
+    queue.pop_front();
+    if (x == tx && y == ty) {
+      return dist[index(x, y)];
+    }
+    for (int k = 0; k < 4; ++k) {
+      int nx = x + dx[k], ny = y + dy[k];
+      if (inside(nx, ny) && dist[index(nx, ny)] == -1) {
+        dist[index(nx, ny)] = dist[index(x, y)] + 1;
+        queue.push_back({nx, ny});
+      }
+    }
+  }
+  return -1;
+}
+
+int main() {
+  Pathfinder pathfinder;
+  std::vector<Pathfinder::Cell> path;
+  int found = 0, unreachable = 0, out_of_window = 0;
+
+  /* Random walls of several densities, around the origin and across
+   * chunk borders.
+   */
+  for (uint64_t seed = 0; seed < 300; ++seed) {
+    std::mt19937 gen{static_cast<uint32_t>(seed)};
+    const int side = 48;
+    int ox = draw(gen, -100, 100), oy = draw(gen, -100, 100);
+    int density = draw(gen, 0, 45);
+    BitGrid walls;
+    for (int x = ox; x < ox + side; ++x) {
+      for (int y = oy; y < oy + side; ++y) {
+        if (draw(gen, 0, 99) < density) {
+          walls.set(x, y);
+        }
+      }
+    }
+    auto view = walls.view();
+    for (int query = 0; query < 20; ++query) {
+      int sx = ox + draw(gen, 0, side - 1);
+      int sy = oy + draw(gen, 0, side - 1);
+      int tx = ox + draw(gen, 0, side - 1);
+      int ty = oy + draw(gen, 0, side - 1);
+      int radius = draw(gen, 1, side);
+      int expected = reference(view, sx, sy, tx, ty, radius);
+      bool ok = pathfinder.find(view, sx, sy, tx, ty, radius, path);
+      assert(ok == (expected != -1));
+      if (!ok) {
+        assert(path.empty());
+        if (std::abs(tx - sx) > radius || std::abs(ty - sy) > radius) {
+          ++out_of_window;
+        } else {
+          ++unreachable;
+        }
+        continue;
+      }
+      ++found;
+      /* Shortest, unbroken, free and inside the window. */
+      assert(static_cast<int>(path.size()) == expected + 1);
+      assert((path.front() == Pathfinder::Cell{sx, sy}));
+      assert((path.back() == Pathfinder::Cell{tx, ty}));
+      for (size_t i = 0; i < path.size(); ++i) {
+        assert(!view.test(path[i].x, path[i].y));
+        assert(std::abs(path[i].x - sx) <= radius);
+        assert(std::abs(path[i].y - sy) <= radius);
+        if (i > 0) {
+          assert(std::abs(path[i].x - path[i - 1].x) +
+                     std::abs(path[i].y - path[i - 1].y) ==
+                 1);
+        }
+      }
+    }
+  }
+  /* All kinds of answers were compared. */
+  assert(found > 1000 && unreachable > 100 && out_of_window > 100);
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+#include "reservation.h"
+
+int main() {
+  ReservationTable table;
+
+  /* Only the first claim of a tile wins, negative coordinates too. */
+  table.reset(4);
+  assert(table.claim(0, 0));
+  assert(!table.claim(0, 0));
+  assert(table.claim(-1, 0));
+  assert(table.claim(0, -1));
+  assert(!table.claim(-1, 0));
+
+  /* A new turn forgets the claims, the table grows on demand. */
+  for (int turn = 0; turn < 3; ++turn) {
+    table.reset(1000);
+    for (int x = 0; x < 1000; ++x) {
+      assert(table.claim(x, turn));
+      assert(!table.claim(x, turn));
+    }
+  }
+  table.reset(1);
+  assert(table.claim(5, 2));
+
+  using Move = ReservationTable::Move;
+  auto nothing = [](int, int) { return false; };
+
+  /* A chain follows its head into a free tile, ties go to the first. */
+  table.resolve({Move{0, 1, 0, 2}, Move{0, 0, 0, 1}, Move{1, 2, 0, 2}},
+                nothing);
+  assert(table.moves(0) && table.moves(1) && !table.moves(2));
+
+  /* A chain behind a held tile or a lost claim stays. */
+  table.resolve({Move{0, 0, 0, 1}, Move{0, 1, 0, 2}},
+                [](int x, int y) { return x == 0 && y == 2; });
+  assert(!table.moves(0) && !table.moves(1));
+  table.resolve({Move{5, 5, 5, 6}, Move{0, 0, 0, 1}, Move{0, 1, 5, 6}},
+                nothing);
+  assert(table.moves(0) && !table.moves(1) && !table.moves(2));
+
+  /* Swaps and rotations go although all their tiles are taken. */
+  auto taken = [](int, int) { return true; };
+  table.resolve({Move{0, 0, 0, 1}, Move{0, 1, 0, 0}}, taken);
+  assert(table.moves(0) && table.moves(1));
+  table.resolve({Move{0, 0, 0, 1}, Move{0, 1, 1, 1}, Move{1, 1, 1, 0},
+                 Move{1, 0, 0, 0}, Move{2, 0, 1, 0}},
+                taken);
+  assert(table.moves(0) && table.moves(1) && table.moves(2) &&
+         table.moves(3) && !table.moves(4));
+
+  /* A long chain is settled whichever end comes first. */
+  std::vector<Move> line;
+  for (int y = 0; y < 1000; ++y) {
+    line.push_back(Move{0, y, 0, y + 1});
+  }
+  table.resolve(line, nothing);
+  for (size_t i = 0; i < line.size(); ++i) {
+    assert(table.moves(i));
+  }
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
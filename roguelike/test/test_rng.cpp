@@ -0,0 +1,42 @@
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+#include "rng.h"
+
+int main() {
+  /* Same seeds give same streams, different seeds and streams differ. */
+  Xoshiro256 a{42}, b{42}, c{43};
+  for (int i = 0; i < 100; ++i) {
+    auto x = a();
+    assert(x == b());
+    assert(x != c());
+  }
+  assert(stream_seed(1, 0) != stream_seed(1, 1));
+  assert(stream_seed(1, 0) != stream_seed(2, 0));
+  assert(stream_id("A") != stream_id("B"));
+
+  /* Bounded draws stay in bounds and hit every value about evenly. */
+  SplitMix64 gen{7};
+  for (uint32_t bound : {1u, 2u, 3u, 5u, 7u, 1000u}) {
+    std::vector<int> hits(bound);
+    const int per_value = 2000;
+    for (uint32_t i = 0; i < bound * per_value; ++i) {
+      auto x = uniform_below(gen, bound);
+      assert(x < bound);
+      ++hits[x];
+    }
+    for (int hit : hits) {
+      assert(hit > per_value * 3 / 4 && hit < per_value * 5 / 4);
+    }
+  }
+  for (int i = 0; i < 1000; ++i) {
+    int x = uniform_int(gen, -3, 3);
+    assert(-3 <= x && x <= 3);
+  }
+  /* The largest bound still needs no division by zero. */
+  uniform_below(gen, UINT32_MAX);
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+#include "room_graph.h"
+
+using Cell = RoomGraph::Cell;
+
+int main() {
+  /* Two rooms joined by a tunnel, a shortcut crossing it, and a room
+   * apart from them.
+   */
+  RoomGraph graph;
+  int a = graph.add_area(0, 0, 4, 4);
+  int tunnel = graph.add_area(2, 5, 2, 9);
+  int b = graph.add_area(0, 10, 4, 14);
+  int crossing = graph.add_area(0, 7, 4, 7);
+  int apart = graph.add_area(20, 20, 24, 24);
+  int corridor = graph.add_area(-40, -3, -38, 70);
+  graph.add_portal({2, 5}, a, tunnel);
+  graph.add_portal({2, 9}, tunnel, b);
+  graph.add_portal({2, 7}, tunnel, crossing);
+
+  /* Tiles map to their area, a crossing to the area added first. */
+  assert(graph.find_area(0, 0) == a && graph.find_area(4, 4) == a);
+  assert(graph.find_area(2, 6) == tunnel);
+  assert(graph.find_area(2, 7) == tunnel);
+  assert(graph.find_area(0, 7) == crossing);
+  assert(graph.find_area(3, 12) == b);
+  assert(graph.find_area(22, 22) == apart);
+  assert(graph.find_area(5, 5) == -1 && graph.find_area(-1, 0) == -1);
+  /* Long areas are found all along. */
+  for (int y = -3; y <= 70; ++y) {
+    assert(graph.find_area(-39, y) == corridor);
+  }
+  assert(graph.find_area(-39, 71) == -1 && graph.find_area(-37, 0) == -1);
+
+  std::vector<Cell> waypoints;
+
+  /* Within a room the target is the only waypoint. */
+  assert(graph.route({1, 1}, {3, 3}, waypoints));
+  assert((waypoints == std::vector<Cell>{{3, 3}}));
+
+  /* Into the next area through the door. */
+  assert(graph.route({1, 1}, {2, 6}, waypoints));
+  assert((waypoints == std::vector<Cell>{{2, 5}, {2, 6}}));
+
+  /* Through the tunnel into the other room, and back. */
+  for (int i = 0; i < 2; ++i) {
+    assert(graph.route({1, 1}, {1, 12}, waypoints));
+    assert((waypoints == std::vector<Cell>{{2, 5}, {2, 9}, {1, 12}}));
+    assert(graph.route({1, 12}, {1, 1}, waypoints));
+    assert((waypoints == std::vector<Cell>{{2, 9}, {2, 5}, {1, 1}}));
+  }
+  assert(graph.route({1, 1}, {0, 7}, waypoints));
+  assert((waypoints == std::vector<Cell>{{2, 5}, {2, 7}, {0, 7}}));
+
+  /* No way to the room apart, nor to tiles out of all areas. */
+  assert(!graph.route({1, 1}, {22, 22}, waypoints));
+  assert(waypoints.empty());
+  assert(!graph.route({22, 22}, {1, 1}, waypoints));
+  assert(!graph.route({1, 1}, {5, 5}, waypoints));
+
+  /* A failed search leaves nothing behind for the next one. */
+  assert(graph.route({3, 12}, {4, 0}, waypoints));
+  assert((waypoints == std::vector<Cell>{{2, 9}, {2, 5}, {4, 0}}));
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
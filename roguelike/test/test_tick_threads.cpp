@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "map.h"
+#include "state.h"
+#include "test/world_fixture.h"
+#include "worker_pool.h"
+
+namespace fs = std::filesystem;
+
+/* Enough mobs for the intent phase to split into several tasks. */
+const int MOBS = 3 * DecisionTreeMob::TICK_GRAIN + 100;
+const int TURNS = 8;
+
+/* Columns of the map after the turns, healths in place of handles. */
+struct Outcome {
+  std::vector<int> xs, ys, healths;
+};
+
+Outcome tick_turns(const fs::path& dir, WorkerPool& pool) {
+  GameState state{std::make_unique<World>(dir)};
+  /* Every mob of the map thinks fully. */
+  ActivityConfig everyone;
+  everyone.interest_radius = everyone.dormant_radius = everyone.wake_radius =
+      1000;
+  state.get_current_map()->set_activity(everyone);
+  auto [px, py] = state.get_player()->get_pos();
+  for (int turn = 0; turn < TURNS; ++turn) {
+    DecisionTreeMob::tick(*state.get_current_map(), px, py, pool);
+  }
+  assert(state.get_current_map()->awake_mobs() == static_cast<size_t>(MOBS));
+
+  auto map = state.get_map();
+  Outcome outcome{{map.xs.begin(), map.xs.end()},
+                  {map.ys.begin(), map.ys.end()},
+                  {}};
+  for (auto object : map.objects) {
+    auto healthable = dynamic_cast<IGameState::IHealthable*>(object);
+    outcome.healths.push_back(
+        healthable != nullptr ? std::get<0>(healthable->get_health()) : -1);
+  }
+  outcome.healths.push_back(std::get<0>(state.get_player()->get_health()));
+  return outcome;
+}
+
+int main() {
+  /* Ranges of a loop are disjoint and cover it. */
+  WorkerPool pool{3};
+  std::vector<int> hits(10000);
+  pool.run(hits.size(), 64, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      ++hits[i];
+    }
+  });
+  for (int hit : hits) {
+    assert(hit == 1);
+  }
+
+  /* Mobs move and strike the player alike on one and on four threads. */
+  auto dir = make_world("test_tick_threads", {.objects = MOBS});
+  WorkerPool serial{0};
+  auto first = tick_turns(dir, serial);
+  auto second = tick_turns(dir, pool);
+  assert(first.xs.size() >= static_cast<size_t>(MOBS));
+  assert(first.xs == second.xs);
+  assert(first.ys == second.ys);
+  assert(first.healths == second.healths);
+
+  GameState start{std::make_unique<World>(dir)};
+  auto map = start.get_map();
+  assert(!std::equal(first.xs.begin(), first.xs.end(), map.xs.begin()) ||
+         !std::equal(first.ys.begin(), first.ys.end(), map.ys.begin()));
+
+  fs::remove_all(dir);
+  std::cout << "OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,129 @@
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+#include "activity.h"
+#include "map.h"
+#include "objects.h"
+#include "room_graph.h"
+#include "state.h"
+#include "test/world_fixture.h"
+#include "turn_budget.h"
+
+using namespace std::chrono_literals;
+namespace fs = std::filesystem;
+
+/* Positions of the objects after some turns under a budget of mob
+ * actions.
+ */
+std::vector<std::tuple<int, int>> play(const fs::path& dir, uint64_t actions,
+                                       uint64_t& deferred) {
+  GameState state{std::make_unique<World>(dir, 3)};
+  state.set_action_budget(actions);
+  for (int i = 0; i < 30; ++i) {
+    state.apply_event(i % 10 < 5 ? IGameState::PlayerMoveEvent::Down
+                                 : IGameState::PlayerMoveEvent::Right);
+  }
+  deferred = state.get_metrics().deferred_mobs;
+  std::vector<std::tuple<int, int>> positions;
+  for (auto object : state.get_map().objects) {
+    positions.push_back(object->get_pos());
+  }
+  return positions;
+}
+
+int main() {
+  /* A default deadline never expires, a spent budget at once. */
+  assert(!Deadline{}.expired());
+  assert(Deadline{0us}.expired());
+  assert(!Deadline{1h}.expired());
+
+  /* A default action budget never runs out. */
+  ActionBudget unlimited;
+  unlimited.spend(1000);
+  assert(!unlimited.spent());
+  ActionBudget actions{3};
+  actions.spend(2);
+  assert(!actions.spent());
+  actions.spend(2);
+  assert(actions.spent());
+
+  /* Jobs run slice by slice in the order they were pushed. */
+  JobQueue jobs;
+  std::vector<int> log;
+  int slices_left = 3;
+  jobs.push([&] {
+    log.push_back(1);
+    return --slices_left == 0;
+  });
+  jobs.push([&] {
+    log.push_back(2);
+    return true;
+  });
+  assert(jobs.size() == 2);
+  /* No time, no slices. */
+  assert(jobs.run(Deadline{0us}) == 0);
+  assert(log.empty());
+  assert(jobs.run(Deadline{}) == 4);
+  assert((log == std::vector<int>{1, 1, 1, 2}));
+  assert(jobs.size() == 0);
+  assert(jobs.run(Deadline{}) == 0);
+
+  /* Coarse picks over the budget of a round are put off, the full
+   * ones act whatever it takes.
+   */
+  EntityStore entities;
+  Bat near{0, 5}, far{0, 30}, farther{0, 31};
+  auto near_handle = entities.push(&near);
+  auto far_handle = entities.push(&far);
+  auto farther_handle = entities.push(&farther);
+  Activity activity;
+  RoomGraph rooms;
+  activity.add(near_handle, 0, 5);
+  activity.add(far_handle, 0, 30);
+  activity.add(farther_handle, 0, 31);
+  activity.begin_turn(entities, 0, 0);
+
+  std::vector<Activity::Pick> picks;
+  assert(activity.next_round(entities, rooms, 0, 0, picks));
+  assert(picks.size() == 3);
+  assert(activity.defer_coarse(entities, picks, 3) == 0 && picks.size() == 3);
+  assert(activity.defer_coarse(entities, picks, 2) == 1);
+  assert(picks.size() == 2);
+  assert(picks[1].index == entities.index(far_handle) && picks[1].coarse);
+  assert(activity.defer_coarse(entities, picks, 0) == 1);
+  assert(picks.size() == 1);
+  assert(picks[0].index == entities.index(near_handle) && !picks[0].coarse);
+  assert(activity.awake_count() == 2);
+  activity.schedule(near_handle, TURN_TIME, false);
+  assert(!activity.next_round(entities, rooms, 0, 0, picks));
+
+  /* The next turn they act after the mobs due in it. */
+  activity.begin_turn(entities, 0, 0);
+  assert(activity.next_round(entities, rooms, 0, 0, picks));
+  assert(picks.size() == 1);
+  assert(picks[0].index == entities.index(near_handle));
+  activity.schedule(near_handle, TURN_TIME, false);
+  assert(activity.next_round(entities, rooms, 0, 0, picks));
+  assert(picks.size() == 2 && picks[0].coarse && picks[1].coarse);
+  assert(picks[0].index == entities.index(far_handle));
+  assert(picks[1].index == entities.index(farther_handle));
+  activity.schedule(far_handle, TURN_TIME, true);
+  activity.schedule(farther_handle, TURN_TIME, true);
+  assert(!activity.next_round(entities, rooms, 0, 0, picks));
+
+  /* Mobs put off over the action budget are the same for a seed. */
+  /* Rows of orcs and bats below the exit. */
+  auto dir = make_world("test_turn_budget", {.objects = 180, .per_row = 30});
+  uint64_t deferred = 0, again = 0;
+  auto positions = play(dir, 4, deferred);
+  assert(deferred > 0);
+  assert(play(dir, 4, again) == positions && again == deferred);
+  fs::remove_all(dir);
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
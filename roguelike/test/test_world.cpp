@@ -0,0 +1,73 @@
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "map.h"
+#include "state.h"
+#include "test/world_fixture.h"
+
+namespace fs = std::filesystem;
+
+/* Terrain of a generated map, which fits in 300 by 300 tiles. */
+uint64_t terrain_hash(const Map& map) {
+  uint64_t hash = 0;
+  for (int x = 0; x < 300; ++x) {
+    for (int y = 0; y < 300; ++y) {
+      hash = hash * 31 + static_cast<uint64_t>(map.get_terrain(x, y));
+    }
+  }
+  return hash;
+}
+
+/* Terrain of the maps behind the enters of the starting map. */
+std::vector<uint64_t> generated(const fs::path& dir, uint64_t seed) {
+  GameState state{std::make_unique<World>(dir, seed)};
+  while (state.run_idle()) {
+  }
+  std::vector<uint64_t> hashes;
+  for (auto object : state.get_map().objects) {
+    if (auto enter = dynamic_cast<Enter*>(object); enter != nullptr) {
+      assert(enter->get_map() != nullptr);
+      hashes.push_back(terrain_hash(*enter->get_map()));
+    }
+  }
+  return hashes;
+}
+
+int main() {
+  /* The exit and two enters to maps which are not there. */
+  auto dir = write_world("test_world", "%  B  C\n");
+
+  /* Each enter leads to its own map, the same for the same seed. */
+  auto first = generated(dir, 7);
+  assert(first.size() == 2);
+  assert(first[0] != first[1]);
+  assert(generated(dir, 7) == first);
+  assert(generated(dir, 8) != first);
+
+  /* An enter taken before its job ran generates its map at once. */
+  GameState state{std::make_unique<World>(dir, 7)};
+  Enter* enter = nullptr;
+  IGameState::ObjectHandle handle{};
+  auto map = state.get_map();
+  for (size_t i = 0; i < map.objects.size(); ++i) {
+    if (auto e = dynamic_cast<Enter*>(map.objects[i]);
+        e != nullptr && e->get_transition() == "B") {
+      enter = e;
+      handle = map.handles[i];
+    }
+  }
+  assert(enter != nullptr && enter->get_map() == nullptr);
+  state.get_player()->set_pos(0, 2);
+  state.apply_event(IGameState::ApplyObjectEvent{handle});
+  assert(enter->get_map() != nullptr);
+  assert(state.get_current_map() == enter->get_map());
+  assert(terrain_hash(*enter->get_map()) == first[0]);
+
+  fs::remove_all(dir);
+  std::cout << "OK" << std::endl;
+  return 0;
+}
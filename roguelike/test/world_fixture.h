@@ -0,0 +1,61 @@
+#pragma once
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// Worlds of a single starting map, written to a directory of their
+// own under the system temporary directory. Tests and benchmarks load
+// them with `World` and remove the directory when they are done.
+
+/* Writes `text` as the starting map of a world named `name`. */
+inline std::filesystem::path write_world(const std::string& name,
+                                         const std::string& text) {
+  auto dir = std::filesystem::temp_directory_path() / ("rl_" + name);
+  std::filesystem::create_directories(dir);
+  std::ofstream(dir / "A.rl") << text;
+  return dir;
+}
+
+// A crowded starting map. The first line holds the exit and `enters`
+// enters, named 'B', 'C' and on, to maps which are not there. Under it
+// `mobs` orcs stand in a staircase near the exit. Then `objects`
+// follow in rows of `per_row`, a free tile before each and a free row
+// between the rows, taking symbols from `kinds` in turn. `borders`
+// border tiles close the map, a row of `2 * per_row` at a time.
+struct WorldSpec {
+  int enters = 0;
+  int mobs = 0;
+  int objects = 0;
+  std::string kinds = "$&";
+  int per_row = 100;
+  int borders = 0;
+};
+
+inline std::filesystem::path make_world(const std::string& name,
+                                        const WorldSpec& spec) {
+  const int width = 2 * spec.per_row;
+  std::string text = "%";
+  for (int i = 0; i < spec.enters; ++i) {
+    text += ' ';
+    text += static_cast<char>('B' + i);
+  }
+  text += '\n';
+  for (int i = 0; i < spec.mobs; ++i) {
+    text += std::string(2 * i % width, ' ') + "$\n";
+  }
+  for (int placed = 0; placed < spec.objects;) {
+    text += '\n';
+    for (int i = 0; i < spec.per_row && placed < spec.objects;
+         ++i, ++placed) {
+      text += ' ';
+      text += spec.kinds[placed % spec.kinds.size()];
+    }
+    text += '\n';
+  }
+  for (int left = spec.borders; left > 0; left -= width) {
+    text += '\n';
+    text += std::string(std::min(left, width), '-') + "\n";
+  }
+  return write_world(name, text);
+}
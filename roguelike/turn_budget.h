@@ -0,0 +1,96 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <utility>
+
+// Wall clock limit of some work. A default one never expires.
+struct Deadline {
+  using Clock = std::chrono::steady_clock;
+
+  Deadline() = default;
+
+  explicit Deadline(Clock::duration budget)
+      : end{Clock::now() + budget}, limited{true} {}
+
+  bool expired() const { return limited && Clock::now() >= end; }
+
+ private:
+  Clock::time_point end{};
+  bool limited = false;
+};
+
+// Limit of mob actions in a turn. Unlike a deadline it does not
+// depend on the machine, so turns under it are the same for the same
+// seed. A default one never runs out.
+struct ActionBudget {
+  ActionBudget() = default;
+
+  explicit ActionBudget(uint64_t actions) : left{actions}, limited{true} {}
+
+  bool spent() const { return limited && left == 0; }
+
+  /* Actions left, the most there is for a default one. */
+  uint64_t remaining() const {
+    return limited ? left : std::numeric_limits<uint64_t>::max();
+  }
+
+  void spend(uint64_t actions) { left -= std::min(left, actions); }
+
+ private:
+  uint64_t left = 0;
+  bool limited = false;
+};
+
+// Deferrable work split into slices. A job runs one slice per call and
+// returns true when it is done, otherwise it is called again later.
+// Jobs run in the order they were pushed.
+struct JobQueue {
+  using Job = std::function<bool()>;
+
+  void push(Job job) { jobs.push_back(std::move(job)); }
+
+  /* Runs slices until the deadline passes or no job is left, returns
+   * the count of slices run.
+   */
+  size_t run(const Deadline& deadline) {
+    size_t slices = 0;
+    while (!jobs.empty() && !deadline.expired()) {
+      if (jobs.front()()) {
+        jobs.pop_front();
+      }
+      ++slices;
+    }
+    return slices;
+  }
+
+  size_t size() const { return jobs.size(); }
+
+ private:
+  std::deque<Job> jobs;
+};
+
+/* What turns cost against their budget, since the start of the game. */
+struct TurnMetrics {
+  /* Wall clock budget of a turn, zero if unlimited. */
+  std::chrono::microseconds budget{0};
+  /* Mob actions in a turn, zero if unlimited. */
+  uint64_t action_budget = 0;
+  /* Time of the last turn and of the slowest one. */
+  std::chrono::microseconds last_turn{0};
+  std::chrono::microseconds worst_turn{0};
+  uint64_t turns = 0;
+  /* Turns which took longer than the budget. */
+  uint64_t deadline_misses = 0;
+  /* Actions of far mobs moved to the next turn, over the action
+   * budget.
+   */
+  uint64_t deferred_mobs = 0;
+  /* Slices of deferred jobs run, during turns or idle, and jobs left. */
+  uint64_t job_slices = 0;
+  size_t pending_jobs = 0;
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads which split a loop over indices between them.
+// Threads are started once and sleep between loops, so a loop costs
+// a wake up, not a thread start.
+struct WorkerPool {
+  /* The calling thread works too, `workers` threads are added. */
+  explicit WorkerPool(unsigned workers) {
+    for (unsigned i = 0; i < workers; ++i) {
+      threads.emplace_back([this] { work(); });
+    }
+  }
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  /* Count of threads taking part in a loop. */
+  unsigned size() const { return static_cast<unsigned>(threads.size()) + 1; }
+
+  // Calls `f(begin, end)` for disjoint ranges of at most `grain`
+  // indices which cover [0, n), returns when all of them are done.
+  // Loops not longer than `grain` run on the calling thread only.
+  template <typename F>
+  void run(size_t n, size_t grain, F&& f) {
+    if (threads.empty() || n <= grain) {
+      f(size_t{0}, n);
+      return;
+    }
+    std::function<void(size_t, size_t)> body = std::forward<F>(f);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      job = &body;
+      job_size = n;
+      job_grain = grain;
+      next.store(0);
+      busy = threads.size();
+      ++generation;
+    }
+    wake.notify_all();
+    take(body, n, grain);
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return busy == 0; });
+    job = nullptr;
+  }
+
+ private:
+  void take(const std::function<void(size_t, size_t)>& body, size_t n,
+            size_t grain) {
+    for (size_t begin = next.fetch_add(grain); begin < n;
+         begin = next.fetch_add(grain)) {
+      body(begin, std::min(n, begin + grain));
+    }
+  }
+
+  void work() {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      wake.wait(lock, [&] { return stop || generation != seen; });
+      if (stop) {
+        return;
+      }
+      seen = generation;
+      auto body = job;
+      size_t n = job_size, grain = job_grain;
+      lock.unlock();
+      take(*body, n, grain);
+      lock.lock();
+      if (--busy == 0) {
+        done.notify_one();
+      }
+    }
+  }
+
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  bool stop = false;
+  uint64_t generation = 0;
+  size_t busy = 0;
+
+  /* The loop being run, published under the mutex. */
+  const std::function<void(size_t, size_t)>* job = nullptr;
+  size_t job_size = 0;
+  size_t job_grain = 0;
+  std::atomic<size_t> next{0};
+};
+
+/* Pool of the process, a thread per core. */
+inline WorkerPool& shared_pool() {
+  static WorkerPool pool{std::max(1u, std::thread::hardware_concurrency()) - 1};
+  return pool;
+}